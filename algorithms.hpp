@@ -1,5 +1,9 @@
 #pragma once
 
+#include <bklib/config.hpp>
+#include <bklib/assert.hpp>
+#include <bklib/math.hpp>
+
 namespace bklib {
 
 //==============================================================================
@@ -31,4 +35,150 @@ auto accumulate_if(Container const& c, Value init, Test test, Sum sum)
     return {count, value};
 }
 
+//==============================================================================
+//! Union-find over the indicies [0, n) with path halving and union by rank.
+//!
+//! @tparam Allocator allocator for the internal storage; rebound as needed.
+//==============================================================================
+template <typename Allocator = std::allocator<size_t>>
+class basic_disjoint_set {
+public:
+    explicit basic_disjoint_set(size_t const n, Allocator const& alloc = Allocator {})
+      : parent_(n, 0, alloc)
+      , rank_(n, 0, alloc)
+    {
+        std::iota(std::begin(parent_), std::end(parent_), size_t {0});
+    }
+
+    size_t size() const BK_NOEXCEPT { return parent_.size(); }
+
+    //--------------------------------------------------------------------------
+    //! Return the representative for the set containing @p i.
+    //--------------------------------------------------------------------------
+    size_t find(size_t i) BK_NOEXCEPT {
+        BK_ASSERT(i < parent_.size());
+
+        while (parent_[i] != i) {
+            parent_[i] = parent_[parent_[i]];
+            i = parent_[i];
+        }
+
+        return i;
+    }
+
+    //--------------------------------------------------------------------------
+    //! Merge the sets containing @p a and @p b.
+    //! @returns false if @p a and @p b were already in the same set.
+    //--------------------------------------------------------------------------
+    bool unite(size_t const a, size_t const b) BK_NOEXCEPT {
+        auto ra = find(a);
+        auto rb = find(b);
+
+        if (ra == rb) {
+            return false;
+        }
+
+        if (rank_[ra] < rank_[rb]) {
+            std::swap(ra, rb);
+        }
+
+        parent_[rb] = ra;
+        if (rank_[ra] == rank_[rb]) {
+            ++rank_[ra];
+        }
+
+        return true;
+    }
+private:
+    template <typename T>
+    using alloc_t = typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+
+    std::vector<size_t,  alloc_t<size_t>>  parent_;
+    std::vector<uint8_t, alloc_t<uint8_t>> rank_;
+};
+
+using disjoint_set = basic_disjoint_set<>;
+
+namespace detail {
+//------------------------------------------------------------------------------
+//! The sweep behind for_each_intersecting_pair; stops as soon as
+//! @c function(i, j) returns false.
+//! @returns false if stopped early.
+//------------------------------------------------------------------------------
+template <typename Rect, typename Allocator, typename Function>
+bool sweep_intersecting_pairs(std::vector<Rect, Allocator> const& rects, Function function) {
+    auto const n = rects.size();
+    if (n < 2) {
+        return true;
+    }
+
+    using index_alloc_t = typename std::allocator_traits<Allocator>::template rebind_alloc<size_t>;
+    using indicies_t    = std::vector<size_t, index_alloc_t>;
+
+    index_alloc_t const alloc {rects.get_allocator()};
+
+    indicies_t order(n, 0, alloc);
+    std::iota(std::begin(order), std::end(order), size_t {0});
+
+    std::sort(std::begin(order), std::end(order), [&](size_t const a, size_t const b) {
+        return rects[a].left() < rects[b].left();
+    });
+
+    indicies_t active(alloc);
+
+    for (auto const i : order) {
+        auto const& r = rects[i];
+
+        //drop everything the sweep line has passed; touching edges are left to
+        //bklib::intersects to decide.
+        active.erase(
+            std::remove_if(std::begin(active), std::end(active), [&](size_t const j) {
+                return rects[j].right() < r.left();
+            })
+          , std::end(active)
+        );
+
+        for (auto const j : active) {
+            if (bklib::intersects(rects[j], r) && !function(j, i)) {
+                return false;
+            }
+        }
+
+        active.push_back(i);
+    }
+
+    return true;
+}
+} //namespace detail
+
+//==============================================================================
+//! Sweep a vertical line from left to right across @c rects and call
+//! @c function(i, j) for every pair of indicies (i, j) whose rects intersect.
+//!
+//! Only rects whose x extents overlap the sweep line are tested against each
+//! other, so for sparse input this is close to O(n log n) rather than O(n^2).
+//! Scratch space comes from the allocator of @c rects.
+//!
+//! @tparam Rect axis_aligned_rect<T>.
+//! @tparam Function Binary function(size_t, size_t).
+//==============================================================================
+template <typename Rect, typename Allocator, typename Function>
+void for_each_intersecting_pair(std::vector<Rect, Allocator> const& rects, Function function) {
+    detail::sweep_intersecting_pairs(rects, [&](size_t const i, size_t const j) {
+        function(i, j);
+        return true;
+    });
+}
+
+//==============================================================================
+//! Whether any two of @c rects intersect; the same sweep as
+//! for_each_intersecting_pair, stopping at the first pair.
+//==============================================================================
+template <typename Rect, typename Allocator>
+bool any_intersecting_pair(std::vector<Rect, Allocator> const& rects) {
+    return !detail::sweep_intersecting_pairs(rects, [](size_t, size_t) {
+        return false;
+    });
+}
+
 } //namespace bklib
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <bklib/config.hpp>
+#include <bklib/assert.hpp>
+
+#include "random.hpp"
+
+namespace tez {
+
+//==============================================================================
+//! A Walker / Vose alias table: samples an index in [0, n) with probability
+//! proportional to its weight in O(1).
+//!
+//! Each pick draws one 32 bit integer for the slot, one 32 bit integer as the
+//! fraction, and reads one slot; there is no search and no floating point at
+//! pick time, unlike std::discrete_distribution.
+//==============================================================================
+class alias_table {
+public:
+    static_assert(random_t::min() == 0 && random_t::max() == 0xFFFFFFFFu
+      , "picks expect full 32 bit draws");
+
+    struct slot_t {
+        uint32_t threshold; //!< keep the slot if a 32 bit draw is below this
+        uint32_t alias;     //!< otherwise, the index to use instead
+    };
+
+    //--------------------------------------------------------------------------
+    //! Build the slots for @p weights into @p out; returns false, and leaves
+    //! @p out empty, if there are no weights or they do not sum to > 0.
+    //--------------------------------------------------------------------------
+    template <typename Weight>
+    static bool build(std::vector<Weight> const& weights, std::vector<slot_t>& out);
+
+    //--------------------------------------------------------------------------
+    //! Pick an index in [0, @p n) from the @p n slots at @p slots.
+    //--------------------------------------------------------------------------
+    static uint32_t pick(slot_t const* slots, uint32_t n, random_t& random);
+
+    //--------------------------------------------------------------------------
+    //! The probability that pick() returns each index of the @p n slots at
+    //! @p slots, as the slots encode it (weights are not kept).
+    //--------------------------------------------------------------------------
+    static std::vector<double> probabilities(slot_t const* slots, uint32_t n);
+
+    //--------------------------------------------------------------------------
+    //! A table with @p slots made by build() earlier; see data_pack.
+    //--------------------------------------------------------------------------
+    static alias_table from_slots(std::vector<slot_t> slots) {
+        alias_table result;
+        result.slots_ = std::move(slots);
+        return result;
+    }
+
+    alias_table() = default;
+
+    //--------------------------------------------------------------------------
+    //! @pre @p weights is not empty and sums to > 0; the parsers check this
+    //! for data read from a file.
+    //--------------------------------------------------------------------------
+    template <typename Weight>
+    explicit alias_table(std::vector<Weight> const& weights) {
+        auto const built = build(weights, slots_);
+        BK_ASSERT(built);
+        BK_UNUSED(built);
+    }
+
+    uint32_t operator()(random_t& random) const {
+        BK_ASSERT(!slots_.empty());
+        return pick(slots_.data(), size(), random);
+    }
+
+    uint32_t size()  const BK_NOEXCEPT { return static_cast<uint32_t>(slots_.size()); }
+    bool     empty() const BK_NOEXCEPT { return slots_.empty(); }
+
+    slot_t const* data() const BK_NOEXCEPT { return slots_.data(); }
+private:
+    std::vector<slot_t> slots_;
+};
+
+template <typename Weight>
+bool alias_table::build(std::vector<Weight> const& weights, std::vector<slot_t>& out) {
+    out.clear();
+
+    auto const n = weights.size();
+
+    double total = 0.0;
+    for (auto const w : weights) {
+        BK_ASSERT(w >= 0);
+        total += static_cast<double>(w);
+    }
+
+    if (n == 0 || !(total > 0.0)) {
+        return false;
+    }
+
+    //Vose: scale so the mean is 1, then repeatedly top up a small slot from a
+    //large one.
+    std::vector<double>   scaled(n);
+    std::vector<uint32_t> small;
+    std::vector<uint32_t> large;
+
+    for (size_t i = 0; i < n; ++i) {
+        scaled[i] = static_cast<double>(weights[i]) * n / total;
+        (scaled[i] < 1.0 ? small : large).push_back(static_cast<uint32_t>(i));
+    }
+
+    out.resize(n);
+
+    double const one = 4294967296.0; //2^32
+
+    while (!small.empty() && !large.empty()) {
+        auto const s = small.back(); small.pop_back();
+        auto const l = large.back();
+
+        out[s].threshold = static_cast<uint32_t>(scaled[s] * one);
+        out[s].alias     = l;
+
+        scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+
+        if (scaled[l] < 1.0) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+
+    //what is left is 1 up to rounding; alias a slot to itself so the draw
+    //against the threshold cannot matter.
+    for (auto const i : large) { out[i].threshold = 0xFFFFFFFFu; out[i].alias = i; }
+    for (auto const i : small) { out[i].threshold = 0xFFFFFFFFu; out[i].alias = i; }
+
+    return true;
+}
+
+inline std::vector<double> alias_table::probabilities(slot_t const* const slots, uint32_t const n) {
+    std::vector<double> result(n, 0.0);
+
+    if (n == 1) {
+        result[0] = 1.0;
+        return result;
+    }
+
+    double const one = 4294967296.0; //2^32
+
+    for (uint32_t i = 0; i < n; ++i) {
+        auto const& slot = slots[i];
+
+        if (slot.alias == i) {
+            result[i] += 1.0 / n;
+            continue;
+        }
+
+        auto const keep = slot.threshold / one;
+
+        result[i]          += keep / n;
+        result[slot.alias] += (1.0 - keep) / n;
+    }
+
+    return result;
+}
+
+inline uint32_t alias_table::pick(slot_t const* const slots, uint32_t const n, random_t& random) {
+    BK_ASSERT(slots && n > 0);
+
+    if (n == 1) {
+        return 0;
+    }
+
+    auto const  i    = random_below(random, n);
+    auto const& slot = slots[i];
+
+    return static_cast<uint32_t>(random()) < slot.threshold ? i : slot.alias;
+}
+
+} //namespace tez
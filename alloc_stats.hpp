@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+
+#include <bklib/config.hpp>
+
+namespace tez {
+
+//==============================================================================
+//! Running totals of the heap allocations made on the calling thread.
+//!
+//! Counted by the replacement global operator new in count_allocations.cpp,
+//! which only the binaries that want the counts (the tests and tez_levelgen)
+//! compile; elsewhere the counts stay zero. Take the difference of two
+//! snapshots to measure a piece of work. Work handed off to other threads is
+//! not included.
+//==============================================================================
+struct allocation_counts {
+    size_t count = 0; //!< number of allocations
+    size_t bytes = 0; //!< bytes requested
+
+    allocation_counts& operator-=(allocation_counts const& rhs) BK_NOEXCEPT {
+        count -= rhs.count;
+        bytes -= rhs.bytes;
+        return *this;
+    }
+};
+
+inline allocation_counts operator-(allocation_counts lhs, allocation_counts const& rhs) BK_NOEXCEPT {
+    return lhs -= rhs;
+}
+
+//! snapshot of the counts for the calling thread.
+allocation_counts thread_allocations() BK_NOEXCEPT;
+
+namespace detail {
+    //! add an allocation of @p size bytes to the counts for the calling thread.
+    void count_allocation(size_t size) BK_NOEXCEPT;
+} //namespace detail
+
+} //namespace tez
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <bklib/config.hpp>
+#include <bklib/assert.hpp>
+
+namespace tez {
+
+//==============================================================================
+//! A monotonic memory resource: allocations are bump allocated from a list of
+//! blocks and are never freed individually; everything is released at once by
+//! reset() or the destructor.
+//!
+//! Safe to allocate from concurrently: an allocation is a compare-and-swap of
+//! the offset into the current block, and the mutex is taken only to add a
+//! block. reset() must not run concurrently with anything else.
+//==============================================================================
+class arena {
+public:
+    static size_t const DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+    arena(arena const&) = delete;
+    arena& operator=(arena const&) = delete;
+
+    explicit arena(size_t block_size = DEFAULT_BLOCK_SIZE);
+
+    //--------------------------------------------------------------------------
+    //! Allocate @p size bytes aligned to @p align (a power of two).
+    //--------------------------------------------------------------------------
+    void* allocate(size_t size, size_t align);
+
+    //--------------------------------------------------------------------------
+    //! Release everything allocated so far. The largest block is kept for
+    //! reuse; the rest are returned to the heap.
+    //--------------------------------------------------------------------------
+    void reset();
+
+    //! number of calls to allocate since the last reset.
+    size_t allocations() const;
+    //! bytes handed out since the last reset.
+    size_t bytes_allocated() const;
+    //! bytes currently held in blocks.
+    size_t bytes_reserved() const;
+    //! number of blocks currently held.
+    size_t block_count() const;
+private:
+    struct block_t {
+        std::unique_ptr<char[]> data;
+        size_t                  size;
+        std::atomic<size_t>     used;
+    };
+
+    static void* try_allocate_(block_t& block, size_t size, size_t align) BK_NOEXCEPT;
+
+    void add_block_(size_t min_size);
+
+    mutable std::mutex                    mutex_;   //!< guards blocks_
+    std::vector<std::unique_ptr<block_t>> blocks_;
+    std::atomic<block_t*>                 current_; //!< blocks_.back(), or null
+    size_t                                block_size_;
+    std::atomic<size_t>                   allocations_;
+    std::atomic<size_t>                   bytes_;
+};
+
+//==============================================================================
+//! Standard allocator drawing from an arena; deallocate is a no-op.
+//!
+//! A default constructed allocator (no arena) uses the heap, so containers
+//! using it need not know whether they are scratch or not. Copies of a
+//! container use the heap too: they may outlive the arena's next reset.
+//==============================================================================
+template <typename T>
+class arena_allocator {
+public:
+    using value_type      = T;
+    using pointer         = T*;
+    using const_pointer   = T const*;
+    using reference       = T&;
+    using const_reference = T const&;
+    using size_type       = size_t;
+    using difference_type = ptrdiff_t;
+
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap            = std::true_type;
+
+    template <typename U>
+    struct rebind {
+        using other = arena_allocator<U>;
+    };
+
+    arena_allocator(tez::arena* const arena = nullptr) BK_NOEXCEPT
+      : arena_ {arena}
+    {
+    }
+
+    template <typename U>
+    arena_allocator(arena_allocator<U> const& other) BK_NOEXCEPT
+      : arena_ {other.get_arena()}
+    {
+    }
+
+    T* allocate(size_t const n) {
+        auto const size = n * sizeof(T);
+
+        return static_cast<T*>(arena_
+          ? arena_->allocate(size, std::alignment_of<T>::value)
+          : ::operator new(size)
+        );
+    }
+
+    void deallocate(T* const p, size_t) BK_NOEXCEPT {
+        if (!arena_) {
+            ::operator delete(p);
+        }
+    }
+
+    size_t max_size() const BK_NOEXCEPT {
+        return static_cast<size_t>(-1) / sizeof(T);
+    }
+
+    //! copies of a container use the heap, not the arena of the original.
+    arena_allocator select_on_container_copy_construction() const BK_NOEXCEPT {
+        return arena_allocator {};
+    }
+
+    tez::arena* get_arena() const BK_NOEXCEPT { return arena_; }
+private:
+    tez::arena* arena_;
+};
+
+template <typename T, typename U>
+inline bool operator==(arena_allocator<T> const& a, arena_allocator<U> const& b) BK_NOEXCEPT {
+    return a.get_arena() == b.get_arena();
+}
+
+template <typename T, typename U>
+inline bool operator!=(arena_allocator<T> const& a, arena_allocator<U> const& b) BK_NOEXCEPT {
+    return !(a == b);
+}
+
+template <typename T>
+using arena_vector = std::vector<T, arena_allocator<T>>;
+
+} //namespace tez
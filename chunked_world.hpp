@@ -0,0 +1,95 @@
+#pragma once
+
+#include <map>
+#include <memory>
+
+#include "level.hpp"
+
+namespace tez {
+
+//==============================================================================
+//! An unbounded map made of fixed-size chunks that are generated on demand.
+//!
+//! Each chunk is a level of params.field_w x params.field_h tiles generated
+//! from a stream derived from (world seed, chunk coordinate), so a chunk is the
+//! same no matter when, or in what order, it is generated.
+//!
+//! Every edge shared by two chunks has one portal; its position is derived
+//! from (world seed, edge) alone, so both chunks agree on it without either
+//! one being generated first. Each chunk carves a corridor from each of its
+//! four portals to its nearest room, which joins the corridors across the
+//! seam.
+//==============================================================================
+class chunked_world {
+public:
+    using params_t = level::params_t;
+    using key_t    = std::pair<int, int>; //!< chunk coordinate (x, y)
+
+    explicit chunked_world(uint64_t world_seed, params_t params = params_t{});
+
+    int chunk_w() const BK_NOEXCEPT { return params_.field_w; }
+    int chunk_h() const BK_NOEXCEPT { return params_.field_h; }
+
+    //--------------------------------------------------------------------------
+    //! The coordinate of the chunk containing the tile at (@p x, @p y).
+    //--------------------------------------------------------------------------
+    key_t chunk_at(int x, int y) const BK_NOEXCEPT;
+
+    //--------------------------------------------------------------------------
+    //! The chunk at @p key; generated if it isn't loaded. The reference is
+    //! invalidated when evict() unloads the chunk; loading others leaves it
+    //! valid.
+    //--------------------------------------------------------------------------
+    level const& chunk(key_t key);
+
+    //--------------------------------------------------------------------------
+    //! The tile at world position (@p x, @p y); its chunk is generated if it
+    //! isn't loaded. As for chunk(), the reference is invalidated by evict().
+    //--------------------------------------------------------------------------
+    tile_data const& at(int x, int y);
+
+    //--------------------------------------------------------------------------
+    //! Generate every chunk within @p radius tiles of (@p x, @p y).
+    //--------------------------------------------------------------------------
+    void require(int x, int y, int radius);
+
+    //--------------------------------------------------------------------------
+    //! Unload every chunk with no tile within @p radius tiles of (@p x, @p y).
+    //! Unloaded chunks are regenerated identically if visited again.
+    //--------------------------------------------------------------------------
+    void evict(int x, int y, int radius);
+
+    bool is_loaded(key_t const key) const {
+        return chunks_.find(key) != std::end(chunks_);
+    }
+
+    //! number of loaded chunks.
+    size_t size() const BK_NOEXCEPT { return chunks_.size(); }
+
+    //--------------------------------------------------------------------------
+    //! Generate the chunk at @p key without loading it.
+    //--------------------------------------------------------------------------
+    level generate(key_t key) const;
+
+    //--------------------------------------------------------------------------
+    //! Offset of the portal on the west edge of the chunk at @p key; the same
+    //! portal is on the east edge of its west neighbour.
+    //--------------------------------------------------------------------------
+    int portal_w(key_t key) const BK_NOEXCEPT;
+
+    //--------------------------------------------------------------------------
+    //! Offset of the portal on the north edge of the chunk at @p key; the same
+    //! portal is on the south edge of its north neighbour.
+    //--------------------------------------------------------------------------
+    int portal_n(key_t key) const BK_NOEXCEPT;
+private:
+    //! the chunk coordinates covered by a square of @p radius around (x, y).
+    std::pair<key_t, key_t> chunk_range_(int x, int y, int radius) const BK_NOEXCEPT;
+
+    uint64_t world_seed_;
+    params_t params_;
+
+    std::map<key_t, std::unique_ptr<level>> chunks_;
+};
+
+} //namespace tez
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "item.hpp"
+#include "loot_table.hpp"
+
+namespace tez {
+
+//==============================================================================
+//! The definition tables compiled into one binary file by tez_datapack, so
+//! startup reads a file instead of parsing json.
+//!
+//! A pack is a header, a pool of every string, then the items and the loot
+//! tables, each written in the order of their container; ids are stored
+//! hashed, flat_maps are filled by appending, and loot tables keep the alias
+//! slots they were built with, so loading hashes, sorts and searches nothing.
+//! Values are written field by field, distributions as their kind and that
+//! kind's parameters, and checked as they are read. Numbers are in the byte
+//! order of the machine that wrote the pack; a pack from another version, or
+//! with another size of hash_t, is rejected.
+//==============================================================================
+struct data_pack {
+    static uint32_t const VERSION = 3;
+
+    //! the first four bytes of a pack; not those of a level patch (see
+    //! write_patch).
+    static char const MAGIC[4];
+
+    struct header_t {
+        char     magic[4];
+        uint32_t version;
+        uint32_t hash_size;         //!< sizeof(hash_t)
+        uint32_t strings_size;      //!< bytes in the string pool
+        uint32_t item_count;
+        uint32_t loot_table_count;
+    };
+
+    item_table::container_t       items;
+    loot_table_table::container_t loot_tables;
+};
+
+//==============================================================================
+//! Write @p items and @p tables as a pack to @p out.
+//==============================================================================
+void write_data_pack(
+    std::ostream&                        out
+  , item_table::container_t const&       items
+  , loot_table_table::container_t const& tables
+);
+
+//==============================================================================
+//! Read the pack of @p size bytes at @p data into @p pack.
+//! @returns false, with @p pack in an unspecified state, if it is not a pack
+//! of this version, is truncated, or holds a count or value out of range.
+//==============================================================================
+bool read_data_pack(char const* data, size_t size, data_pack& pack);
+
+//==============================================================================
+//! Read the pack at @p filename and publish its tables to item_table and
+//! loot_table_table.
+//! @returns false, leaving the tables as they were, if it cannot be read.
+//==============================================================================
+bool load_data_pack(utf8string const& filename);
+
+} //namespace tez
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "types.hpp"
+
+namespace tez {
+
+//==============================================================================
+//! Calls back when watched files change, from a background thread.
+//!
+//! Changes are seen with inotify on Linux and by polling each file's
+//! modification time and size elsewhere. Editors often save in several steps
+//! (truncate, write, rename), so a file is reported once it has been left
+//! alone for @c settle; a burst of writes gives one call.
+//==============================================================================
+class file_watcher {
+public:
+    using callback_t = std::function<void (utf8string const& path)>;
+    using duration   = std::chrono::milliseconds;
+
+    file_watcher(file_watcher const&) = delete;
+    file_watcher& operator=(file_watcher const&) = delete;
+
+    explicit file_watcher(
+        duration settle   = duration {100}
+      , duration interval = duration {250} //!< how often files are polled
+    );
+
+    ~file_watcher();
+
+    //--------------------------------------------------------------------------
+    //! Call @p callback on the watcher's thread whenever @p path changes.
+    //--------------------------------------------------------------------------
+    void watch(utf8string path, callback_t callback);
+
+    //--------------------------------------------------------------------------
+    //! Call @p callback on the thread that calls dispatch() whenever @p path
+    //! changes; for state that is not safe to touch from another thread.
+    //--------------------------------------------------------------------------
+    void watch_deferred(utf8string path, callback_t callback);
+
+    //--------------------------------------------------------------------------
+    //! Call the deferred callbacks of the changes seen since the last call.
+    //! @returns the number of callbacks called.
+    //--------------------------------------------------------------------------
+    size_t dispatch();
+private:
+    using clock = std::chrono::steady_clock;
+
+    struct file_t {
+        utf8string        path;
+        callback_t        callback;
+        bool              deferred;
+        bool              pending = false;
+        clock::time_point due;
+    };
+
+    //the inotify descriptor, or the last seen stamps of the files.
+    struct platform_t;
+
+    void add_(utf8string&& path, callback_t&& callback, bool deferred);
+
+    void work_();
+
+    duration settle_;
+    duration interval_;
+
+    std::unique_ptr<platform_t> platform_;
+
+    std::mutex          mutex_;
+    std::vector<file_t> files_;
+    std::deque<size_t>  ready_; //!< deferred files to dispatch
+    bool                stop_ = false;
+
+    std::thread worker_;
+};
+
+} //namespace tez
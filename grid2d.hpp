@@ -304,6 +304,16 @@ public:
         return (i.x < width_) && (i.y < height_);
     }
 
+    //! the first element of row @p y; each row is width() contiguous elements.
+    T* row(index_t const y) {
+        BK_ASSERT(y < height_);
+        return data_.data() + y * width_;
+    }
+
+    T const* row(index_t const y) const {
+        return const_cast<grid2d*>(this)->row(y);
+    }
+
     //sub_iterator begin(point pa, point pb) {
     //    reorder(pa, pb);
 
@@ -355,4 +365,21 @@ private:
 };
 //==============================================================================
 
+//==============================================================================
+//! Copy all of @p src into @p dst with its top left corner at (@p x, @p y);
+//! one contiguous copy per row.
+//==============================================================================
+template <typename T>
+void blit(grid2d<T> const& src, grid2d<T>& dst, size_t const x, size_t const y) {
+    BK_ASSERT(x + src.width()  <= dst.width());
+    BK_ASSERT(y + src.height() <= dst.height());
+
+    auto const w = src.width();
+
+    for (size_t i = 0; i < src.height(); ++i) {
+        std::copy_n(src.row(i), w, dst.row(y + i) + x);
+    }
+}
+//==============================================================================
+
 } //namespace tez
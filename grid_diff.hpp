@@ -0,0 +1,348 @@
+#pragma once
+
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include "grid2d.hpp"
+
+namespace tez {
+
+//==============================================================================
+//! A 64 bit hash of each CHUNK_SIZE x CHUNK_SIZE chunk of a grid2d.
+//!
+//! Compute it once for a grid, then rehash() the chunk of each tile that is
+//! changed; comparing two sets of hashes finds the changed chunks without
+//! touching the tiles of the others.
+//==============================================================================
+template <typename T>
+class grid_chunk_hashes {
+public:
+    static_assert(std::is_trivially_copyable<T>::value, "tiles are hashed as bytes");
+
+    static size_t const CHUNK_SIZE = 16;
+
+    grid_chunk_hashes() = default;
+
+    explicit grid_chunk_hashes(grid2d<T> const& grid)
+      : width_  {grid.width()}
+      , height_ {grid.height()}
+      , chunks_w_ {(grid.width()  + CHUNK_SIZE - 1) / CHUNK_SIZE}
+      , chunks_h_ {(grid.height() + CHUNK_SIZE - 1) / CHUNK_SIZE}
+      , hashes_ (chunks_w_ * chunks_h_)
+    {
+        for (size_t cy = 0; cy < chunks_h_; ++cy) {
+            for (size_t cx = 0; cx < chunks_w_; ++cx) {
+                hashes_[cy * chunks_w_ + cx] = hash_chunk_(grid, cx, cy);
+            }
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    //! Recompute the hash of the chunk containing the tile at (@p x, @p y).
+    //--------------------------------------------------------------------------
+    void rehash(grid2d<T> const& grid, size_t const x, size_t const y) {
+        BK_ASSERT(grid.width() == width_ && grid.height() == height_);
+        BK_ASSERT(x < width_ && y < height_);
+
+        auto const cx = x / CHUNK_SIZE;
+        auto const cy = y / CHUNK_SIZE;
+
+        hashes_[cy * chunks_w_ + cx] = hash_chunk_(grid, cx, cy);
+    }
+
+    size_t width()    const BK_NOEXCEPT { return width_; }
+    size_t height()   const BK_NOEXCEPT { return height_; }
+    size_t chunks_w() const BK_NOEXCEPT { return chunks_w_; }
+    size_t chunks_h() const BK_NOEXCEPT { return chunks_h_; }
+
+    uint64_t operator()(size_t const cx, size_t const cy) const {
+        BK_ASSERT(cx < chunks_w_ && cy < chunks_h_);
+        return hashes_[cy * chunks_w_ + cx];
+    }
+private:
+    //FNV-1a over the bytes of each row of the chunk
+    static uint64_t hash_chunk_(grid2d<T> const& grid, size_t const cx, size_t const cy) {
+        auto const x0 = cx * CHUNK_SIZE;
+        auto const y0 = cy * CHUNK_SIZE;
+        auto const x1 = std::min(x0 + CHUNK_SIZE, grid.width());
+        auto const y1 = std::min(y0 + CHUNK_SIZE, grid.height());
+
+        uint64_t h = 14695981039346656037ull;
+
+        for (auto y = y0; y < y1; ++y) {
+            auto const first = reinterpret_cast<unsigned char const*>(grid.row(y) + x0);
+            auto const last  = reinterpret_cast<unsigned char const*>(grid.row(y) + x1);
+
+            for (auto it = first; it != last; ++it) {
+                h ^= *it;
+                h *= 1099511628211ull;
+            }
+        }
+
+        return h;
+    }
+
+    size_t width_    = 0;
+    size_t height_   = 0;
+    size_t chunks_w_ = 0;
+    size_t chunks_h_ = 0;
+
+    std::vector<uint64_t> hashes_;
+};
+
+//==============================================================================
+//! The tiles that differ between two grids of the same size, as runs of
+//! consecutive tiles in row major order; the size is proportional to the
+//! number of changed tiles, not to the size of the grid.
+//==============================================================================
+template <typename T>
+struct grid_patch {
+    struct run_t {
+        uint32_t offset; //!< index of the first tile; y * width + x
+        uint32_t length;
+    };
+
+    uint32_t width  = 0;
+    uint32_t height = 0;
+
+    std::vector<run_t> runs;   //!< sorted and disjoint
+    std::vector<T>     values; //!< the new tiles of every run, in order
+
+    bool empty() const BK_NOEXCEPT { return runs.empty(); }
+};
+
+namespace detail {
+    //! same as memcmp == 0 on the tiles; T has no operator== in general.
+    template <typename T>
+    inline bool same_tile(T const& a, T const& b) BK_NOEXCEPT {
+        return std::memcmp(&a, &b, sizeof(T)) == 0;
+    }
+
+    inline void write_varint(std::ostream& out, uint32_t x) {
+        while (x >= 0x80) {
+            out.put(static_cast<char>((x & 0x7F) | 0x80));
+            x >>= 7;
+        }
+
+        out.put(static_cast<char>(x));
+    }
+
+    inline bool read_varint(std::istream& in, uint32_t& out) {
+        out = 0;
+
+        for (int shift = 0; shift < 32; shift += 7) {
+            auto const c = in.get();
+            if (c == std::istream::traits_type::eof()) {
+                return false;
+            }
+
+            out |= static_cast<uint32_t>(c & 0x7F) << shift;
+
+            if (!(c & 0x80)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+} //namespace detail
+
+//==============================================================================
+//! The patch that turns @p base into @p current. Only the chunks whose hashes
+//! differ are compared tile by tile.
+//==============================================================================
+template <typename T>
+grid_patch<T> make_patch(
+    grid2d<T> const& base,    grid_chunk_hashes<T> const& base_hashes
+  , grid2d<T> const& current, grid_chunk_hashes<T> const& current_hashes
+) {
+    BK_ASSERT(base.width() == current.width() && base.height() == current.height());
+    BK_ASSERT(base_hashes.width() == base.width() && base_hashes.height() == base.height());
+    BK_ASSERT(current_hashes.width() == current.width() && current_hashes.height() == current.height());
+
+    using run_t = typename grid_patch<T>::run_t;
+
+    size_t const chunk = grid_chunk_hashes<T>::CHUNK_SIZE;
+    auto   const w     = base.width();
+    auto   const h     = base.height();
+
+    //(offset, length) of the changed runs, in chunk order
+    std::vector<run_t> runs;
+
+    for (size_t cy = 0; cy < base_hashes.chunks_h(); ++cy) {
+        for (size_t cx = 0; cx < base_hashes.chunks_w(); ++cx) {
+            if (base_hashes(cx, cy) == current_hashes(cx, cy)) {
+                continue;
+            }
+
+            auto const x0 = cx * chunk;
+            auto const x1 = std::min(x0 + chunk, w);
+            auto const y1 = std::min(cy * chunk + chunk, h);
+
+            for (auto y = cy * chunk; y < y1; ++y) {
+                auto const a = base.row(y);
+                auto const b = current.row(y);
+
+                for (auto x = x0; x < x1; ) {
+                    if (detail::same_tile(a[x], b[x])) {
+                        ++x;
+                        continue;
+                    }
+
+                    auto const first = x;
+                    while (x < x1 && !detail::same_tile(a[x], b[x])) {
+                        ++x;
+                    }
+
+                    runs.push_back(run_t {
+                        static_cast<uint32_t>(y * w + first)
+                      , static_cast<uint32_t>(x - first)
+                    });
+                }
+            }
+        }
+    }
+
+    std::sort(std::begin(runs), std::end(runs), [](run_t const& l, run_t const& r) {
+        return l.offset < r.offset;
+    });
+
+    grid_patch<T> result;
+    result.width  = static_cast<uint32_t>(w);
+    result.height = static_cast<uint32_t>(h);
+
+    //join runs split by a chunk boundary
+    for (auto const& run : runs) {
+        auto& out = result.runs;
+        if (!out.empty() && out.back().offset + out.back().length == run.offset) {
+            out.back().length += run.length;
+        } else {
+            out.push_back(run);
+        }
+    }
+
+    if (result.empty()) {
+        return result;
+    }
+
+    auto const tiles = current.row(0);
+    for (auto const& run : result.runs) {
+        result.values.insert(
+            std::end(result.values), tiles + run.offset, tiles + run.offset + run.length
+        );
+    }
+
+    return result;
+}
+
+//==============================================================================
+//! The patch that turns @p base into @p current; hashes both in full.
+//==============================================================================
+template <typename T>
+grid_patch<T> make_patch(grid2d<T> const& base, grid2d<T> const& current) {
+    return make_patch(
+        base,    grid_chunk_hashes<T> {base}
+      , current, grid_chunk_hashes<T> {current}
+    );
+}
+
+//==============================================================================
+//! Apply @p patch to @p grid; one contiguous copy per run.
+//==============================================================================
+template <typename T>
+void apply_patch(grid_patch<T> const& patch, grid2d<T>& grid) {
+    BK_ASSERT(grid.width() == patch.width && grid.height() == patch.height);
+
+    if (patch.empty()) {
+        return;
+    }
+
+    auto const tiles = grid.row(0);
+    auto       value = patch.values.data();
+
+    for (auto const& run : patch.runs) {
+        BK_ASSERT(run.offset + run.length <= grid.size());
+
+        std::copy_n(value, run.length, tiles + run.offset);
+        value += run.length;
+    }
+}
+
+//==============================================================================
+//! "TEZP", uint32 width, uint32 height, uint32 run count; then per run the
+//! varint gap from the end of the previous run and the varint length; then
+//! the raw values of every run.
+//==============================================================================
+template <typename T>
+void write_patch(std::ostream& out, grid_patch<T> const& patch) {
+    char const magic[4] = {'T', 'E', 'Z', 'P'};
+    auto const count    = static_cast<uint32_t>(patch.runs.size());
+
+    out.write(magic, sizeof(magic));
+    out.write(reinterpret_cast<char const*>(&patch.width),  sizeof(patch.width));
+    out.write(reinterpret_cast<char const*>(&patch.height), sizeof(patch.height));
+    out.write(reinterpret_cast<char const*>(&count),        sizeof(count));
+
+    uint32_t end = 0;
+    for (auto const& run : patch.runs) {
+        detail::write_varint(out, run.offset - end);
+        detail::write_varint(out, run.length);
+        end = run.offset + run.length;
+    }
+
+    out.write(
+        reinterpret_cast<char const*>(patch.values.data())
+      , patch.values.size() * sizeof(T)
+    );
+}
+
+//==============================================================================
+//! Read a patch written by write_patch.
+//! @returns false if the data is malformed; @p patch is unspecified then.
+//==============================================================================
+template <typename T>
+bool read_patch(std::istream& in, grid_patch<T>& patch) {
+    char     magic[4] = {};
+    uint32_t count    = 0;
+
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&patch.width),  sizeof(patch.width));
+    in.read(reinterpret_cast<char*>(&patch.height), sizeof(patch.height));
+    in.read(reinterpret_cast<char*>(&count),        sizeof(count));
+
+    if (!in || std::memcmp(magic, "TEZP", 4) != 0) {
+        return false;
+    }
+
+    auto const size = static_cast<uint64_t>(patch.width) * patch.height;
+
+    patch.runs.clear();
+
+    uint64_t end   = 0;
+    uint64_t total = 0;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t gap, length;
+        if (!detail::read_varint(in, gap) || !detail::read_varint(in, length)) {
+            return false;
+        }
+
+        auto const offset = end + gap;
+        end    = offset + length;
+        total += length;
+
+        if (end > size) {
+            return false;
+        }
+
+        patch.runs.push_back({static_cast<uint32_t>(offset), length});
+    }
+
+    patch.values.resize(static_cast<size_t>(total));
+    in.read(reinterpret_cast<char*>(patch.values.data()), total * sizeof(T));
+
+    return static_cast<bool>(in);
+}
+
+} //namespace tez
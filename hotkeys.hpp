@@ -114,6 +114,15 @@ public:
     void reload(string_ref file = DEFAULT_FILE_NAME);
     void reload(std::istream& in);
 
+    //--------------------------------------------------------------------------
+    //! Reparse the bindings from @p file (or @p in); if it is not well formed,
+    //! report why and keep the current bindings. For reloading the file as it
+    //! is edited.
+    //! @returns whether the bindings were replaced.
+    //--------------------------------------------------------------------------
+    bool try_reload(utf8string const& file);
+    bool try_reload(std::istream& in);
+
     //--------------------------------------------------------------------------
     //! Iterate through all bindings that are a subset of @p keys.
     //--------------------------------------------------------------------------
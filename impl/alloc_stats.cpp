@@ -0,0 +1,26 @@
+#include "alloc_stats.hpp"
+
+#if BOOST_COMP_MSVC
+#   define TEZ_THREAD_LOCAL __declspec(thread)
+#else
+#   define TEZ_THREAD_LOCAL thread_local
+#endif
+
+namespace {
+
+TEZ_THREAD_LOCAL size_t allocation_count = 0;
+TEZ_THREAD_LOCAL size_t allocation_bytes = 0;
+
+} //namespace
+
+void tez::detail::count_allocation(size_t const size) BK_NOEXCEPT {
+    ++allocation_count;
+    allocation_bytes += size;
+}
+
+tez::allocation_counts tez::thread_allocations() BK_NOEXCEPT {
+    allocation_counts result;
+    result.count = allocation_count;
+    result.bytes = allocation_bytes;
+    return result;
+}
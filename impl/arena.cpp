@@ -0,0 +1,127 @@
+#include "arena.hpp"
+
+using tez::arena;
+
+arena::arena(size_t const block_size)
+  : current_     {nullptr}
+  , block_size_  {block_size}
+  , allocations_ {0}
+  , bytes_       {0}
+{
+    BK_ASSERT(block_size > 0);
+}
+
+void* arena::allocate(size_t const size, size_t const align) {
+    BK_ASSERT(align && (align & (align - 1)) == 0);
+
+    for (;;) {
+        auto const block = current_.load(std::memory_order_acquire);
+
+        if (block) {
+            if (auto const result = try_allocate_(*block, size, align)) {
+                allocations_.fetch_add(1, std::memory_order_relaxed);
+                bytes_.fetch_add(size, std::memory_order_relaxed);
+                return result;
+            }
+        }
+
+        //full; unless another thread got here first, add a block that fits
+        std::lock_guard<std::mutex> lock {mutex_};
+        if (current_.load(std::memory_order_relaxed) == block) {
+            add_block_(size + align - 1);
+        }
+    }
+}
+
+void arena::reset() {
+    std::lock_guard<std::mutex> lock {mutex_};
+
+    if (blocks_.size() > 1) {
+        auto const largest = std::max_element(std::begin(blocks_), std::end(blocks_)
+          , [](std::unique_ptr<block_t> const& a, std::unique_ptr<block_t> const& b) {
+                return a->size < b->size;
+            });
+
+        auto keep = std::move(*largest);
+        blocks_.clear();
+        blocks_.push_back(std::move(keep));
+    }
+
+    if (!blocks_.empty()) {
+        blocks_.back()->used.store(0, std::memory_order_relaxed);
+        current_.store(blocks_.back().get(), std::memory_order_release);
+    }
+
+    allocations_.store(0, std::memory_order_relaxed);
+    bytes_.store(0, std::memory_order_relaxed);
+}
+
+size_t arena::allocations() const {
+    return allocations_.load(std::memory_order_relaxed);
+}
+
+size_t arena::bytes_allocated() const {
+    return bytes_.load(std::memory_order_relaxed);
+}
+
+size_t arena::bytes_reserved() const {
+    std::lock_guard<std::mutex> lock {mutex_};
+
+    size_t result = 0;
+    for (auto const& block : blocks_) {
+        result += block->size;
+    }
+
+    return result;
+}
+
+size_t arena::block_count() const {
+    std::lock_guard<std::mutex> lock {mutex_};
+    return blocks_.size();
+}
+
+//------------------------------------------------------------------------------
+//! Bump the offset into @p block.
+//! @returns nullptr if the allocation does not fit.
+//------------------------------------------------------------------------------
+void* arena::try_allocate_(
+    block_t&     block
+  , size_t const size
+  , size_t const align
+) BK_NOEXCEPT {
+    auto const base = reinterpret_cast<uintptr_t>(block.data.get());
+    auto       used = block.used.load(std::memory_order_relaxed);
+
+    for (;;) {
+        auto const first = (base + used + align - 1) & ~static_cast<uintptr_t>(align - 1);
+
+        if (first + size > base + block.size) {
+            return nullptr;
+        }
+
+        auto const next = static_cast<size_t>(first + size - base);
+
+        if (block.used.compare_exchange_weak(used, next, std::memory_order_relaxed)) {
+            return reinterpret_cast<void*>(first);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+//! Blocks double in size so the number of blocks grows with the log of the
+//! total size. Called with mutex_ held.
+//------------------------------------------------------------------------------
+void arena::add_block_(size_t const min_size) {
+    auto size = blocks_.empty() ? block_size_ : blocks_.back()->size * 2;
+    if (size < min_size) {
+        size = min_size;
+    }
+
+    std::unique_ptr<block_t> block {new block_t};
+    block->data.reset(new char[size]);
+    block->size = size;
+    block->used.store(0, std::memory_order_relaxed);
+
+    blocks_.push_back(std::move(block));
+    current_.store(blocks_.back().get(), std::memory_order_release);
+}
@@ -0,0 +1,208 @@
+#include "chunked_world.hpp"
+
+using tez::chunked_world;
+
+namespace {
+
+//! seed domains; keeps chunk and portal streams for the same key independent.
+enum : uint64_t {
+    DOMAIN_CHUNK, DOMAIN_PORTAL_W, DOMAIN_PORTAL_N
+};
+
+uint64_t pack(chunked_world::key_t const key) BK_NOEXCEPT {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(key.first)) << 32)
+         | static_cast<uint64_t>(static_cast<uint32_t>(key.second));
+}
+
+int floor_div(int const n, int const d) BK_NOEXCEPT {
+    return (n >= 0) ? n / d : -((-n + d - 1) / d);
+}
+
+//------------------------------------------------------------------------------
+//! A position in [1, length - 2] derived from @p seed; keeps portals off the
+//! chunk corners.
+//------------------------------------------------------------------------------
+int portal_offset(uint64_t const seed, int const length) BK_NOEXCEPT {
+    BK_ASSERT(length >= 3);
+    return 1 + static_cast<int>(seed % static_cast<uint64_t>(length - 2));
+}
+
+//------------------------------------------------------------------------------
+//! Carve a corridor from the edge tile (@p x, @p y) to the nearest room; first
+//! along the axis away from the edge, then along the other. Stops at the first
+//! floor tile reached. Without rooms, heads for the center of the grid so the
+//! corridors from all four portals still meet.
+//------------------------------------------------------------------------------
+void carve_portal(
+    tile_grid& grid
+  , std::vector<room_rect_set> const& rooms
+  , int x, int y
+  , bool const horizontal_first
+) {
+    using tile_type = tile_data::tile_type;
+
+    int tx = static_cast<int>(grid.width())  / 2;
+    int ty = static_cast<int>(grid.height()) / 2;
+
+    tile_data corridor;
+    corridor.type = tile_type::corridor;
+
+    int best = std::numeric_limits<int>::max();
+
+    for (size_t i = 0; i < rooms.size(); ++i) {
+        if (rooms[i].empty()) {
+            continue;
+        }
+
+        auto const cx = rooms[i].px(0, 0);
+        auto const cy = rooms[i].py(0, 0);
+        auto const d  = std::abs(cx - x) + std::abs(cy - y);
+
+        if (d < best) {
+            best = d;
+            tx   = cx;
+            ty   = cy;
+            corridor.room_id = static_cast<tile_data::room_id_t>(i + 1);
+        }
+    }
+
+    //returns false when a floor tile is reached
+    auto const carve = [&](int const xx, int const yy) {
+        auto& tile = grid.at(xx, yy);
+
+        if (tile.type == tile_type::floor) {
+            return false;
+        } else if (tile.type == tile_type::empty) {
+            tile = corridor;
+        }
+
+        return true;
+    };
+
+    auto const step_x = [&] {
+        while (x != tx) {
+            x += (tx > x) ? 1 : -1;
+            if (!carve(x, y)) return false;
+        }
+        return true;
+    };
+
+    auto const step_y = [&] {
+        while (y != ty) {
+            y += (ty > y) ? 1 : -1;
+            if (!carve(x, y)) return false;
+        }
+        return true;
+    };
+
+    if (!carve(x, y)) {
+        return;
+    }
+
+    if (horizontal_first) {
+        step_x() && step_y();
+    } else {
+        step_y() && step_x();
+    }
+}
+
+} //namespace
+
+chunked_world::chunked_world(uint64_t const world_seed, params_t const params)
+  : world_seed_ {world_seed}
+  , params_     {params}
+{
+    BK_ASSERT(params_.field_w >= 3 && params_.field_h >= 3);
+}
+
+chunked_world::key_t chunked_world::chunk_at(int const x, int const y) const BK_NOEXCEPT {
+    return key_t {floor_div(x, chunk_w()), floor_div(y, chunk_h())};
+}
+
+level const& chunked_world::chunk(key_t const key) {
+    auto& result = chunks_[key];
+
+    if (!result) {
+        result = std::make_unique<level>(generate(key));
+    }
+
+    return *result;
+}
+
+tile_data const& chunked_world::at(int const x, int const y) {
+    auto const key = chunk_at(x, y);
+    auto const& c  = chunk(key);
+
+    return c.grid_.at(
+        static_cast<size_t>(x - key.first  * chunk_w())
+      , static_cast<size_t>(y - key.second * chunk_h())
+    );
+}
+
+void chunked_world::require(int const x, int const y, int const radius) {
+    auto const range = chunk_range_(x, y, radius);
+
+    for (auto cy = range.first.second; cy <= range.second.second; ++cy) {
+        for (auto cx = range.first.first; cx <= range.second.first; ++cx) {
+            chunk(key_t {cx, cy});
+        }
+    }
+}
+
+void chunked_world::evict(int const x, int const y, int const radius) {
+    auto const range = chunk_range_(x, y, radius);
+
+    auto const keep = [&](key_t const& key) {
+        return key.first  >= range.first.first  && key.first  <= range.second.first
+            && key.second >= range.first.second && key.second <= range.second.second;
+    };
+
+    for (auto it = std::begin(chunks_); it != std::end(chunks_); ) {
+        if (keep(it->first)) {
+            ++it;
+        } else {
+            it = chunks_.erase(it);
+        }
+    }
+}
+
+level chunked_world::generate(key_t const key) const {
+    auto random = tez::make_stream(tez::derive_seed(world_seed_, DOMAIN_CHUNK), pack(key));
+    level result {random, params_};
+
+    auto const w = chunk_w();
+    auto const h = chunk_h();
+
+    auto const west  = portal_w(key);
+    auto const east  = portal_w(key_t {key.first + 1, key.second});
+    auto const north = portal_n(key);
+    auto const south = portal_n(key_t {key.first, key.second + 1});
+
+    auto& grid = result.grid_;
+    auto const& rooms = result.room_defs_;
+
+    carve_portal(grid, rooms, 0,     west,  true);
+    carve_portal(grid, rooms, w - 1, east,  true);
+    carve_portal(grid, rooms, north, 0,     false);
+    carve_portal(grid, rooms, south, h - 1, false);
+
+    return result;
+}
+
+int chunked_world::portal_w(key_t const key) const BK_NOEXCEPT {
+    auto const seed = tez::derive_seed(tez::derive_seed(world_seed_, DOMAIN_PORTAL_W), pack(key));
+    return portal_offset(seed, chunk_h());
+}
+
+int chunked_world::portal_n(key_t const key) const BK_NOEXCEPT {
+    auto const seed = tez::derive_seed(tez::derive_seed(world_seed_, DOMAIN_PORTAL_N), pack(key));
+    return portal_offset(seed, chunk_w());
+}
+
+std::pair<chunked_world::key_t, chunked_world::key_t>
+chunked_world::chunk_range_(int const x, int const y, int const radius) const BK_NOEXCEPT {
+    return std::make_pair(
+        chunk_at(x - radius, y - radius)
+      , chunk_at(x + radius, y + radius)
+    );
+}
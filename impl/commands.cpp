@@ -51,6 +51,8 @@ void init() {
     BK_ADD_COMMAND_STRING(COMMAND::DIR_SOUTH_WEST);
     BK_ADD_COMMAND_STRING(COMMAND::DIR_SOUTH);
     BK_ADD_COMMAND_STRING(COMMAND::DIR_SOUTH_EAST);
+    BK_ADD_COMMAND_STRING(COMMAND::DIR_UP);
+    BK_ADD_COMMAND_STRING(COMMAND::DIR_DOWN);
     //##########################################################################
     #undef BK_ADD_COMMAND_STRING
     //##########################################################################
@@ -0,0 +1,140 @@
+//==============================================================================
+//! Replacement global allocation functions that feed tez::thread_allocations.
+//!
+//! Not part of tez_lib: only binaries that measure allocations (the tests and
+//! tez_levelgen) compile this file, so the game keeps the standard operators.
+//==============================================================================
+#include "alloc_stats.hpp"
+
+namespace {
+
+void* allocate(size_t const size) BK_NOEXCEPT {
+    tez::detail::count_allocation(size);
+    return std::malloc(size ? size : 1);
+}
+
+#if defined(__cpp_aligned_new)
+void* allocate(size_t const size, std::align_val_t const align) BK_NOEXCEPT {
+    tez::detail::count_allocation(size);
+
+    auto const a = static_cast<size_t>(align);
+    auto const n = (size ? size + a - 1 : a) / a * a;
+
+#   if BOOST_OS_WINDOWS
+    return _aligned_malloc(n, a);
+#   else
+    return std::aligned_alloc(a, n);
+#   endif
+}
+
+void deallocate(void* const p, std::align_val_t) BK_NOEXCEPT {
+#   if BOOST_OS_WINDOWS
+    _aligned_free(p);
+#   else
+    std::free(p);
+#   endif
+}
+#endif
+
+} //namespace
+
+////////////////////////////////////////////////////////////////////////////////
+// replacement global allocation functions
+////////////////////////////////////////////////////////////////////////////////
+void* operator new(size_t const size) {
+    if (auto const p = allocate(size)) {
+        return p;
+    }
+
+    throw std::bad_alloc {};
+}
+
+void* operator new[](size_t const size) {
+    return ::operator new(size);
+}
+
+void* operator new(size_t const size, std::nothrow_t const&) BK_NOEXCEPT {
+    return allocate(size);
+}
+
+void* operator new[](size_t const size, std::nothrow_t const&) BK_NOEXCEPT {
+    return allocate(size);
+}
+
+void operator delete(void* const p) BK_NOEXCEPT {
+    std::free(p);
+}
+
+void operator delete[](void* const p) BK_NOEXCEPT {
+    std::free(p);
+}
+
+void operator delete(void* const p, std::nothrow_t const&) BK_NOEXCEPT {
+    std::free(p);
+}
+
+void operator delete[](void* const p, std::nothrow_t const&) BK_NOEXCEPT {
+    std::free(p);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// sized deallocation (C++14)
+////////////////////////////////////////////////////////////////////////////////
+#if defined(__cpp_sized_deallocation)
+void operator delete(void* const p, size_t) BK_NOEXCEPT {
+    std::free(p);
+}
+
+void operator delete[](void* const p, size_t) BK_NOEXCEPT {
+    std::free(p);
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// over-aligned allocation (C++17)
+////////////////////////////////////////////////////////////////////////////////
+#if defined(__cpp_aligned_new)
+void* operator new(size_t const size, std::align_val_t const align) {
+    if (auto const p = allocate(size, align)) {
+        return p;
+    }
+
+    throw std::bad_alloc {};
+}
+
+void* operator new[](size_t const size, std::align_val_t const align) {
+    return ::operator new(size, align);
+}
+
+void* operator new(size_t const size, std::align_val_t const align, std::nothrow_t const&) BK_NOEXCEPT {
+    return allocate(size, align);
+}
+
+void* operator new[](size_t const size, std::align_val_t const align, std::nothrow_t const&) BK_NOEXCEPT {
+    return allocate(size, align);
+}
+
+void operator delete(void* const p, std::align_val_t const align) BK_NOEXCEPT {
+    deallocate(p, align);
+}
+
+void operator delete[](void* const p, std::align_val_t const align) BK_NOEXCEPT {
+    deallocate(p, align);
+}
+
+void operator delete(void* const p, std::align_val_t const align, std::nothrow_t const&) BK_NOEXCEPT {
+    deallocate(p, align);
+}
+
+void operator delete[](void* const p, std::align_val_t const align, std::nothrow_t const&) BK_NOEXCEPT {
+    deallocate(p, align);
+}
+
+void operator delete(void* const p, size_t, std::align_val_t const align) BK_NOEXCEPT {
+    deallocate(p, align);
+}
+
+void operator delete[](void* const p, size_t, std::align_val_t const align) BK_NOEXCEPT {
+    deallocate(p, align);
+}
+#endif
@@ -0,0 +1,554 @@
+#include "data_pack.hpp"
+
+#include <unordered_map>
+
+using tez::data_pack;
+using tez::item_definition;
+using tez::item_attribute;
+using tez::loot_table;
+using tez::distribution;
+using tez::alias_table;
+using tez::utf8string;
+using tez::string_ref;
+using tez::hash_t;
+
+uint32_t const data_pack::VERSION;
+char const     data_pack::MAGIC[4] = {'T', 'E', 'Z', 'D'};
+
+namespace {
+
+uint8_t const ENTRY_ITEM  = 0;
+uint8_t const ENTRY_TABLE = 1;
+
+//------------------------------------------------------------------------------
+// the smallest record of each kind, to bound counts read from a pack by the
+// bytes left to hold them.
+//------------------------------------------------------------------------------
+size_t const STRING_SIZE       = 2 * sizeof(uint32_t); //offset, size
+size_t const DISTRIBUTION_SIZE = 1 + sizeof(int32_t);  //kind, a fixed value
+size_t const ATTRIBUTE_SIZE    = sizeof(hash_t) + 1 + sizeof(int32_t);
+size_t const ENTRY_SIZE        = 1 + sizeof(hash_t) + DISTRIBUTION_SIZE;
+size_t const LOOT_TABLE_SIZE   = sizeof(hash_t) + STRING_SIZE + sizeof(uint32_t);
+
+//ref, category, type, id; weight, base value and four counts
+size_t const ITEM_SIZE = 3 * sizeof(hash_t) + STRING_SIZE + 6 * sizeof(uint32_t);
+
+//------------------------------------------------------------------------------
+//! Appends values to the body of a pack; strings go to a shared pool.
+//------------------------------------------------------------------------------
+class pack_writer {
+public:
+    template <typename T>
+    void put(T const& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "");
+
+        auto const first = reinterpret_cast<char const*>(&value);
+        body_.insert(std::end(body_), first, first + sizeof(T));
+    }
+
+    template <typename T>
+    void put_size(T const& container) {
+        put(static_cast<uint32_t>(container.size()));
+    }
+
+    //! the offset and size of @p string in the pool; equal strings are
+    //! stored once.
+    void put_string(string_ref const string) {
+        auto key = string.to_string();
+
+        auto where = offsets_.find(key);
+        if (where == std::end(offsets_)) {
+            auto const offset = static_cast<uint32_t>(strings_.size());
+            strings_.insert(std::end(strings_), std::begin(string), std::end(string));
+            where = offsets_.emplace(std::move(key), offset).first;
+        }
+
+        put(where->second);
+        put(static_cast<uint32_t>(string.size()));
+    }
+
+    std::vector<char> const& strings() const { return strings_; }
+    std::vector<char> const& body()    const { return body_; }
+private:
+    std::vector<char> strings_;
+    std::vector<char> body_;
+
+    std::unordered_map<std::string, uint32_t> offsets_;
+};
+
+//------------------------------------------------------------------------------
+//! Reads values of a pack; every read is bounds checked, and the first
+//! failure sticks so callers can check ok() once per record.
+//------------------------------------------------------------------------------
+class pack_reader {
+public:
+    pack_reader(char const* const first, char const* const last)
+      : pos_ {first}
+      , end_ {last}
+    {
+    }
+
+    bool ok() const BK_NOEXCEPT { return ok_; }
+
+    template <typename T>
+    T get() {
+        static_assert(std::is_trivially_copyable<T>::value, "");
+
+        T result {};
+
+        if (!ok_ || static_cast<size_t>(end_ - pos_) < sizeof(T)) {
+            ok_ = false;
+            return result;
+        }
+
+        std::memcpy(&result, pos_, sizeof(T));
+        pos_ += sizeof(T);
+
+        return result;
+    }
+
+    //! a count of elements at least @p element_size bytes each; 0 if there
+    //! are not that many bytes left.
+    uint32_t get_count(size_t const element_size) {
+        return check_count(get<uint32_t>(), element_size);
+    }
+
+    //! @p n if there are bytes left for @p n elements of at least
+    //! @p element_size bytes each; otherwise 0, and a failure.
+    uint32_t check_count(uint32_t const n, size_t const element_size) {
+        if (!ok_ || n > static_cast<size_t>(end_ - pos_) / element_size) {
+            ok_ = false;
+            return 0;
+        }
+
+        return n;
+    }
+
+    //! the next @p n bytes.
+    char const* skip(size_t const n) {
+        if (!ok_ || static_cast<size_t>(end_ - pos_) < n) {
+            ok_ = false;
+            return pos_;
+        }
+
+        auto const result = pos_;
+        pos_ += n;
+
+        return result;
+    }
+
+    void set_strings(char const* const strings, uint32_t const size) {
+        strings_      = strings;
+        strings_size_ = size;
+    }
+
+    utf8string get_string() {
+        auto const offset = get<uint32_t>();
+        auto const size   = get<uint32_t>();
+
+        if (!ok_ || offset > strings_size_ || size > strings_size_ - offset) {
+            ok_ = false;
+            return utf8string {};
+        }
+
+        return utf8string {strings_ + offset, size};
+    }
+private:
+    char const* pos_;
+    char const* end_;
+    bool        ok_ = true;
+
+    char const* strings_      = nullptr;
+    uint32_t    strings_size_ = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// write
+////////////////////////////////////////////////////////////////////////////////
+void write_strings(pack_writer& out, tez::language_string_map const& map) {
+    out.put_size(map.strings());
+    for (auto const& value : map.strings()) {
+        out.put(value.first.value);
+        out.put_string(value.second);
+    }
+}
+
+//------------------------------------------------------------------------------
+//! The kind, then only the parameters of that kind; never the raw union.
+//------------------------------------------------------------------------------
+void write_distribution(pack_writer& out, distribution const& dist) {
+    out.put(static_cast<uint8_t>(dist.type()));
+
+    switch (dist.type()) {
+    case distribution::kind::fixed :
+        out.put(dist.fixed());
+        break;
+    case distribution::kind::uniform :
+        out.put(dist.uniform().min);
+        out.put(dist.uniform().max);
+        break;
+    case distribution::kind::normal :
+        out.put(dist.normal().mean);
+        out.put(dist.normal().stddev);
+        break;
+    case distribution::kind::binomial :
+        out.put(dist.binomial().trials);
+        out.put(dist.binomial().p);
+        break;
+    case distribution::kind::poisson :
+        out.put(dist.poisson().mean);
+        break;
+    }
+}
+
+void write_item(pack_writer& out, tez::item_ref const ref, item_definition const& item) {
+    out.put(ref.value);
+    out.put_string(item.id.string);
+    out.put(item.category.value);
+    out.put(item.type.value);
+    out.put(static_cast<uint32_t>(item.weight));
+    out.put(static_cast<uint32_t>(item.base_value));
+
+    out.put_size(item.tags);
+    for (auto const tag : item.tags) {
+        out.put(tag.value);
+    }
+
+    out.put_size(item.attributes);
+    for (auto const& attribute : item.attributes) {
+        out.put(attribute.name().value);
+        out.put(static_cast<uint8_t>(attribute.kind()));
+
+        switch (attribute.kind()) {
+        case item_attribute::type::integer :
+            out.put(attribute.int_value()); break;
+        case item_attribute::type::floating_point :
+            out.put(attribute.float_value()); break;
+        case item_attribute::type::string :
+            out.put_string(attribute.string_value()); break;
+        }
+    }
+
+    write_strings(out, item.names);
+    write_strings(out, item.descriptions);
+}
+
+void write_loot_table(pack_writer& out, tez::loot_table_ref const ref, loot_table const& table) {
+    auto const& entries = table.entries();
+    auto const& picker  = table.picker();
+
+    BK_ASSERT(picker.size() == entries.size());
+
+    out.put(ref.value);
+    out.put_string(table.id());
+
+    out.put_size(entries);
+    for (auto const& entry : entries) {
+        if (auto const item = boost::get<tez::item_ref>(&entry.value)) {
+            out.put(ENTRY_ITEM);
+            out.put(item->value);
+        } else {
+            out.put(ENTRY_TABLE);
+            out.put(boost::get<tez::loot_table_ref>(entry.value).value);
+        }
+
+        write_distribution(out, entry.count);
+    }
+
+    for (uint32_t i = 0; i < picker.size(); ++i) {
+        out.put(picker.data()[i].threshold);
+        out.put(picker.data()[i].alias);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// read
+////////////////////////////////////////////////////////////////////////////////
+tez::language_string_map read_strings(pack_reader& in) {
+    tez::language_string_map::container_t strings;
+
+    auto const n = in.get_count(sizeof(hash_t) + STRING_SIZE);
+    strings.reserve(n);
+
+    for (uint32_t i = 0; i < n && in.ok(); ++i) {
+        auto const language = in.get<hash_t>();
+        strings.emplace_hint(std::end(strings), tez::language_ref {language}, in.get_string());
+    }
+
+    return tez::language_string_map {std::move(strings)};
+}
+
+//------------------------------------------------------------------------------
+//! Read a distribution into @p out; false if it is not one that the make_
+//! functions of distribution would accept.
+//------------------------------------------------------------------------------
+bool read_distribution(pack_reader& in, distribution& out) {
+    using kind = distribution::kind;
+
+    switch (static_cast<kind>(in.get<uint8_t>())) {
+    case kind::fixed :
+        out = distribution::make_fixed(in.get<int32_t>());
+        return true;
+    case kind::uniform : {
+        auto const min = in.get<int32_t>();
+        auto const max = in.get<int32_t>();
+        if (!(min <= max)) {
+            return false;
+        }
+
+        out = distribution::make_uniform_int(min, max);
+        return true;
+    }
+    case kind::normal : {
+        auto const mean   = in.get<float>();
+        auto const stddev = in.get<float>();
+        if (!std::isfinite(mean) || !std::isfinite(stddev) || !(stddev >= 0.0f)) {
+            return false;
+        }
+
+        out = distribution::make_normal(mean, stddev);
+        return true;
+    }
+    case kind::binomial : {
+        auto const trials = in.get<int32_t>();
+        auto const p      = in.get<float>();
+        if (!(trials >= 0) || !(p >= 0.0f && p <= 1.0f)) {
+            return false;
+        }
+
+        out = distribution::make_binomial(trials, p);
+        return true;
+    }
+    case kind::poisson : {
+        auto const mean = in.get<float>();
+        if (!std::isfinite(mean) || !(mean >= 0.0f)) {
+            return false;
+        }
+
+        out = distribution::make_poisson(mean);
+        return true;
+    }
+    }
+
+    return false;
+}
+
+bool read_item(pack_reader& in, tez::item_table::container_t& items) {
+    auto const ref = tez::item_ref {in.get<hash_t>()};
+
+    item_definition item;
+
+    item.id.string  = in.get_string();
+    item.id.hash    = ref.value;
+    item.category   = tez::item_category_ref {in.get<hash_t>()};
+    item.type       = tez::item_type_ref {in.get<hash_t>()};
+    item.weight     = in.get<uint32_t>();
+    item.base_value = in.get<uint32_t>();
+
+    auto const tag_count = in.get_count(sizeof(hash_t));
+    item.tags.reserve(tag_count);
+    for (uint32_t i = 0; i < tag_count && in.ok(); ++i) {
+        item.tags.emplace_hint(std::end(item.tags), tez::item_tag_ref {in.get<hash_t>()});
+    }
+
+    auto const attribute_count = in.get_count(ATTRIBUTE_SIZE);
+    item.attributes.reserve(attribute_count);
+    for (uint32_t i = 0; i < attribute_count && in.ok(); ++i) {
+        auto const name = tez::item_attribute_ref {in.get<hash_t>()};
+        auto const kind = static_cast<item_attribute::type>(in.get<uint8_t>());
+
+        auto const where = std::end(item.attributes);
+
+        switch (kind) {
+        case item_attribute::type::integer :
+            item.attributes.emplace_hint(where, name, in.get<int32_t>()); break;
+        case item_attribute::type::floating_point :
+            item.attributes.emplace_hint(where, name, in.get<float>()); break;
+        case item_attribute::type::string :
+            item.attributes.emplace_hint(where, name, in.get_string()); break;
+        default :
+            return false;
+        }
+    }
+
+    item.names        = read_strings(in);
+    item.descriptions = read_strings(in);
+
+    if (!in.ok()) {
+        return false;
+    }
+
+    items.emplace_hint(std::end(items), ref, std::move(item));
+
+    return true;
+}
+
+bool read_loot_table(pack_reader& in, tez::loot_table_table::container_t& tables) {
+    auto const ref = tez::loot_table_ref {in.get<hash_t>()};
+    auto       id  = in.get_string();
+
+    //as the parser, a table must have something to pick
+    auto const n = in.get_count(ENTRY_SIZE);
+    if (n == 0) {
+        return false;
+    }
+
+    loot_table::table_entries entries;
+    entries.reserve(n);
+
+    for (uint32_t i = 0; i < n && in.ok(); ++i) {
+        auto const type   = in.get<uint8_t>();
+        auto const target = in.get<hash_t>();
+
+        distribution count;
+        if (!read_distribution(in, count)) {
+            return false;
+        }
+
+        if (type == ENTRY_ITEM) {
+            entries.emplace_back(tez::item_ref {target}, count);
+        } else if (type == ENTRY_TABLE) {
+            entries.emplace_back(tez::loot_table_ref {target}, count);
+        } else {
+            return false;
+        }
+    }
+
+    std::vector<alias_table::slot_t> slots;
+    slots.reserve(n);
+
+    for (uint32_t i = 0; i < n && in.ok(); ++i) {
+        alias_table::slot_t slot;
+        slot.threshold = in.get<uint32_t>();
+        slot.alias     = in.get<uint32_t>();
+
+        if (slot.alias >= n) {
+            return false;
+        }
+
+        slots.push_back(slot);
+    }
+
+    if (!in.ok()) {
+        return false;
+    }
+
+    tables.emplace_hint(std::end(tables), ref, loot_table {
+        std::move(id)
+      , std::move(entries)
+      , alias_table::from_slots(std::move(slots))
+    });
+
+    return true;
+}
+
+} //namespace
+
+////////////////////////////////////////////////////////////////////////////////
+// tez::write_data_pack
+////////////////////////////////////////////////////////////////////////////////
+void tez::write_data_pack(
+    std::ostream&                        out
+  , item_table::container_t const&       items
+  , loot_table_table::container_t const& tables
+) {
+    pack_writer writer;
+
+    for (auto const& value : items) {
+        write_item(writer, value.first, value.second);
+    }
+
+    for (auto const& value : tables) {
+        write_loot_table(writer, value.first, value.second);
+    }
+
+    auto const& strings = writer.strings();
+    auto const& body    = writer.body();
+
+    data_pack::header_t header;
+    std::copy(std::begin(data_pack::MAGIC), std::end(data_pack::MAGIC), header.magic);
+    header.version           = data_pack::VERSION;
+    header.hash_size         = sizeof(hash_t);
+    header.strings_size      = static_cast<uint32_t>(strings.size());
+    header.item_count        = static_cast<uint32_t>(items.size());
+    header.loot_table_count  = static_cast<uint32_t>(tables.size());
+
+    out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    out.write(strings.data(), strings.size());
+    out.write(body.data(), body.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// tez::read_data_pack
+////////////////////////////////////////////////////////////////////////////////
+bool tez::read_data_pack(char const* const data, size_t const size, data_pack& pack) {
+    pack_reader in {data, data + size};
+
+    auto const header = in.get<data_pack::header_t>();
+
+    if (!in.ok()
+     || !std::equal(std::begin(data_pack::MAGIC), std::end(data_pack::MAGIC), header.magic)
+     || header.version           != data_pack::VERSION
+     || header.hash_size         != sizeof(hash_t)
+    ) {
+        return false;
+    }
+
+    in.set_strings(in.skip(header.strings_size), header.strings_size);
+
+    //bound by what the rest of the pack could hold before reserving
+    auto const item_count = in.check_count(header.item_count, ITEM_SIZE);
+
+    pack.items.clear();
+    pack.items.reserve(item_count);
+
+    for (uint32_t i = 0; i < item_count; ++i) {
+        if (!read_item(in, pack.items)) {
+            return false;
+        }
+    }
+
+    auto const table_count = in.check_count(header.loot_table_count, LOOT_TABLE_SIZE);
+
+    pack.loot_tables.clear();
+    pack.loot_tables.reserve(table_count);
+
+    for (uint32_t i = 0; i < table_count; ++i) {
+        if (!read_loot_table(in, pack.loot_tables)) {
+            return false;
+        }
+    }
+
+    return in.ok();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// tez::load_data_pack
+////////////////////////////////////////////////////////////////////////////////
+bool tez::load_data_pack(utf8string const& filename) {
+    std::ifstream in {filename, std::ios::binary};
+    if (!in) {
+        return false;
+    }
+
+    in.seekg(0, std::ios::end);
+    auto const size = static_cast<size_t>(in.tellg());
+    in.seekg(0, std::ios::beg);
+
+    std::vector<char> bytes(size);
+    if (!in.read(bytes.data(), size)) {
+        return false;
+    }
+
+    data_pack pack;
+    if (!read_data_pack(bytes.data(), bytes.size(), pack)) {
+        std::cout << filename << " is not a data pack of version " << data_pack::VERSION << std::endl;
+        return false;
+    }
+
+    //items first, so linking the loot tables checks their items against them
+    item_table::publish(std::move(pack.items));
+    loot_table_table::publish(std::move(pack.loot_tables));
+
+    return true;
+}
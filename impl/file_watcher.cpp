@@ -0,0 +1,350 @@
+#include "file_watcher.hpp"
+
+#include <bklib/assert.hpp>
+#include <bklib/config.hpp>
+
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#if BOOST_OS_LINUX
+#   include <poll.h>
+#   include <unistd.h>
+#   include <sys/inotify.h>
+#endif
+
+using tez::file_watcher;
+using tez::utf8string;
+
+namespace {
+
+//! the part of @p path up to and including its last separator; "" if none.
+utf8string directory_of(utf8string const& path) {
+    auto const i = path.find_last_of("/\\");
+    return i == utf8string::npos ? utf8string {} : path.substr(0, i + 1);
+}
+
+} //namespace
+
+namespace {
+
+//------------------------------------------------------------------------------
+//! Finds changed files by their modification time and size.
+//------------------------------------------------------------------------------
+class stamp_poller {
+public:
+    void add(utf8string const& path) {
+        files_.push_back(file_t {path, stamp_(path)});
+    }
+
+    //! call changed(path) for each file whose stamp is not what it was.
+    template <typename Changed>
+    void check(Changed changed) {
+        for (auto& file : files_) {
+            auto const stamp = stamp_(file.path);
+            if (stamp != file.stamp) {
+                file.stamp = stamp;
+                changed(file.path);
+            }
+        }
+    }
+private:
+    //! modification time and size; zeros for a missing file.
+    using stamp_t = std::pair<int64_t, int64_t>;
+
+    struct file_t {
+        utf8string path;
+        stamp_t    stamp;
+    };
+
+    static stamp_t stamp_(utf8string const& path) {
+    #if BOOST_OS_WINDOWS
+        struct _stat64 info;
+        if (::_stat64(path.c_str(), &info)) {
+            return stamp_t {0, 0};
+        }
+    #else
+        struct stat info;
+        if (::stat(path.c_str(), &info)) {
+            return stamp_t {0, 0};
+        }
+    #endif
+
+        return stamp_t {
+            static_cast<int64_t>(info.st_mtime)
+          , static_cast<int64_t>(info.st_size)
+        };
+    }
+
+    std::vector<file_t> files_;
+};
+
+} //namespace
+
+#if BOOST_OS_LINUX
+////////////////////////////////////////////////////////////////////////////////
+// file_watcher::platform_t -- inotify
+//
+// A file that cannot be watched (no inotify, a missing directory, the watch
+// limit reached) is reported and polled instead.
+////////////////////////////////////////////////////////////////////////////////
+struct file_watcher::platform_t {
+    platform_t()
+      : fd_ {::inotify_init1(IN_NONBLOCK | IN_CLOEXEC)}
+    {
+        if (fd_ < 0) {
+            std::cout << "file_watcher: inotify is unavailable ("
+                      << std::strerror(errno) << "); polling instead" << std::endl;
+        }
+    }
+
+    ~platform_t() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    //! Watch the directory of @p path rather than the file itself: editors
+    //! that save by renaming a new file over the old one would otherwise
+    //! leave the watch on a file that is gone.
+    //!
+    //! Events are matched to files by watch descriptor and name, so files in
+    //! one directory spelt differently ("data/" and "./data/") each keep
+    //! their own path.
+    //--------------------------------------------------------------------------
+    void add(utf8string const& path) {
+        if (fd_ < 0) {
+            poller_.add(path);
+            return;
+        }
+
+        auto const dir = directory_of(path);
+        auto const wd  = ::inotify_add_watch(
+            fd_
+          , dir.empty() ? "." : dir.c_str()
+          , IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE
+        );
+
+        if (wd < 0) {
+            std::cout << "file_watcher: can't watch " << path << " ("
+                      << std::strerror(errno) << "); polling it instead" << std::endl;
+            poller_.add(path);
+            return;
+        }
+
+        //the same directory gives the same wd
+        files_.push_back(file_t {wd, path.substr(dir.size()), path});
+    }
+
+    //--------------------------------------------------------------------------
+    //! Wait up to @p timeout with @p lock unlocked, then call changed(path)
+    //! for each file written since the last call.
+    //--------------------------------------------------------------------------
+    template <typename Changed>
+    void wait(std::unique_lock<std::mutex>& lock, duration const timeout, Changed changed) {
+        lock.unlock();
+
+        events_.clear();
+
+        if (fd_ < 0) {
+            std::this_thread::sleep_for(timeout);
+        } else {
+            pollfd p {fd_, POLLIN, 0};
+            if (::poll(&p, 1, static_cast<int>(timeout.count())) > 0) {
+                read_();
+            }
+        }
+
+        lock.lock();
+
+        for (auto const& event : events_) {
+            for (auto const& file : files_) {
+                if (file.wd == event.first && file.name == event.second) {
+                    changed(file.path);
+                }
+            }
+        }
+
+        poller_.check(changed);
+    }
+private:
+    void read_() {
+        alignas(inotify_event) char buffer[4096];
+
+        for (;;) {
+            auto const n = ::read(fd_, buffer, sizeof(buffer));
+            if (n <= 0) {
+                break;
+            }
+
+            for (auto p = buffer; p < buffer + n; ) {
+                auto const event = reinterpret_cast<inotify_event const*>(p);
+                if (event->len) {
+                    events_.emplace_back(event->wd, utf8string {event->name});
+                }
+
+                p += sizeof(inotify_event) + event->len;
+            }
+        }
+    }
+
+    struct file_t {
+        int        wd;
+        utf8string name; //!< the file name, without the directory
+        utf8string path; //!< as given to add
+    };
+
+    int                                     fd_;
+    std::vector<file_t>                     files_;
+    std::vector<std::pair<int, utf8string>> events_; //!< wd and file name
+    stamp_poller                            poller_; //!< files inotify can't watch
+};
+#else
+////////////////////////////////////////////////////////////////////////////////
+// file_watcher::platform_t -- polling
+////////////////////////////////////////////////////////////////////////////////
+struct file_watcher::platform_t {
+    void add(utf8string const& path) {
+        poller_.add(path);
+    }
+
+    //--------------------------------------------------------------------------
+    //! Wait @p timeout with @p lock unlocked, then call changed(path) for each
+    //! file whose modification time or size is not what it was.
+    //--------------------------------------------------------------------------
+    template <typename Changed>
+    void wait(std::unique_lock<std::mutex>& lock, duration const timeout, Changed changed) {
+        lock.unlock();
+        std::this_thread::sleep_for(timeout);
+        lock.lock();
+
+        poller_.check(changed);
+    }
+private:
+    stamp_poller poller_;
+};
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// tez::file_watcher
+////////////////////////////////////////////////////////////////////////////////
+file_watcher::file_watcher(duration const settle, duration const interval)
+  : settle_   {settle}
+  , interval_ {interval}
+  , platform_ {std::make_unique<platform_t>()}
+{
+    worker_ = std::thread {[this] { work_(); }};
+}
+
+file_watcher::~file_watcher() {
+    {
+        std::lock_guard<std::mutex> lock {mutex_};
+        stop_ = true;
+    }
+
+    worker_.join();
+}
+
+void file_watcher::watch(utf8string path, callback_t callback) {
+    add_(std::move(path), std::move(callback), false);
+}
+
+void file_watcher::watch_deferred(utf8string path, callback_t callback) {
+    add_(std::move(path), std::move(callback), true);
+}
+
+void file_watcher::add_(utf8string&& path, callback_t&& callback, bool const deferred) {
+    std::lock_guard<std::mutex> lock {mutex_};
+
+    platform_->add(path);
+
+    file_t file;
+    file.path     = std::move(path);
+    file.callback = std::move(callback);
+    file.deferred = deferred;
+
+    files_.push_back(std::move(file));
+}
+
+size_t file_watcher::dispatch() {
+    std::vector<std::pair<utf8string, callback_t>> calls;
+
+    {
+        std::lock_guard<std::mutex> lock {mutex_};
+
+        for (auto const i : ready_) {
+            calls.emplace_back(files_[i].path, files_[i].callback);
+        }
+
+        ready_.clear();
+    }
+
+    for (auto const& call : calls) {
+        call.second(call.first);
+    }
+
+    return calls.size();
+}
+
+void file_watcher::work_() {
+    std::vector<std::pair<utf8string, callback_t>> calls;
+
+    std::unique_lock<std::mutex> lock {mutex_};
+
+    while (!stop_) {
+        //wake for the earliest settled file, or at least every interval
+        auto timeout = interval_;
+        auto now     = clock::now();
+
+        for (auto const& file : files_) {
+            if (file.pending) {
+                auto const left = std::chrono::duration_cast<duration>(file.due - now);
+                timeout = std::max(duration {1}, std::min(timeout, left));
+            }
+        }
+
+        platform_->wait(lock, timeout, [&](utf8string const& path) {
+            for (auto& file : files_) {
+                if (file.path == path) {
+                    file.pending = true;
+                    file.due     = clock::now() + settle_;
+                }
+            }
+        });
+
+        now = clock::now();
+
+        for (size_t i = 0; i < files_.size(); ++i) {
+            auto& file = files_[i];
+            if (!file.pending || file.due > now) {
+                continue;
+            }
+
+            file.pending = false;
+
+            if (!file.deferred) {
+                calls.emplace_back(file.path, file.callback);
+            } else if (std::find(std::begin(ready_), std::end(ready_), i) == std::end(ready_)) {
+                ready_.push_back(i);
+            }
+        }
+
+        if (calls.empty()) {
+            continue;
+        }
+
+        //callbacks may take a while (a reparse) and may watch more files
+        lock.unlock();
+
+        for (auto const& call : calls) {
+            call.second(call.first);
+        }
+
+        calls.clear();
+
+        lock.lock();
+    }
+}
@@ -11,6 +11,7 @@ using tez::string_ref;
 using tez::key_combo;
 using tez::keycode;
 using tez::make_string_ref;
+using tez::utf8string;
 
 ////////////////////////////////////////////////////////////////////////////////
 // tez::key_bindings
@@ -32,6 +33,39 @@ void key_bindings::reload(std::istream& in) {
     mappings_ = parser.get();
 }
 
+bool key_bindings::try_reload(utf8string const& file) {
+    std::ifstream in {file};
+    if (!in) {
+        std::cout << "couldn't open " << file << std::endl;
+        return false;
+    }
+
+    return try_reload(in);
+}
+
+bool key_bindings::try_reload(std::istream& in) {
+    Json::Reader reader;
+    Json::Value  root;
+
+    if (!reader.parse(in, root)) {
+        std::cout << reader.getFormattedErrorMessages();
+        return false;
+    }
+
+    bindings_parser parser;
+
+    try {
+        parser.parse(root);
+    } catch (json::error::base const& e) {
+        std::cout << boost::diagnostic_information(e);
+        return false;
+    }
+
+    mappings_ = parser.get();
+
+    return true;
+}
+
 command_t key_bindings::match(key_combo const& keys) const {
     auto const result = mappings_.find(keys);
     return result != std::cend(mappings_)
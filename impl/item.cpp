@@ -288,5 +288,4 @@ void item_parser::rule_item_desc(cref json_value) {
 // item_table
 ////////////////////////////////////////////////////////////////////////////////
 
-bool                         tez::item_table::is_loaded_ {false};
-tez::item_table::container_t tez::item_table::data_      {};
+tez::item_table::state_t tez::item_table::state_ {};
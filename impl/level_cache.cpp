@@ -0,0 +1,645 @@
+#include "level_cache.hpp"
+
+#if BOOST_OS_WINDOWS
+#   include <windows.h>
+#   include <direct.h>
+#   include <process.h>
+#else
+#   include <dirent.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+using tez::level_cache;
+
+namespace {
+
+//------------------------------------------------------------------------------
+// file: "TEZC", uint32 FORMAT_VERSION, uint64 key,
+//       uint32 room count, per room: uint32 rect count, per rect:
+//           int32 base[4], uint8 has_hole, int32 hole[4] (if has_hole)
+//       uint32 width, uint32 height, uint32 run count, per run:
+//           varint length, varint type, varint sub_type, varint room_id
+//
+// all fixed size values are in native byte order; varints are LEB128.
+//------------------------------------------------------------------------------
+char     const MAGIC[4]       = {'T', 'E', 'Z', 'C'};
+uint32_t const FORMAT_VERSION = 1;
+
+char const FILE_EXTENSION[] = ".lvl";
+char const INDEX_NAME[]     = "index";
+
+//------------------------------------------------------------------------------
+// FNV-1a
+//------------------------------------------------------------------------------
+struct hasher {
+    uint64_t value = 14695981039346656037ull;
+
+    template <typename T>
+    void operator()(T const& x) {
+        auto const bytes = reinterpret_cast<unsigned char const*>(&x);
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            value ^= bytes[i];
+            value *= 1099511628211ull;
+        }
+    }
+};
+
+class writer {
+public:
+    template <typename T>
+    void operator()(T const x) {
+        static_assert(std::is_arithmetic<T>::value, "");
+
+        auto const bytes = reinterpret_cast<char const*>(&x);
+        buffer_.insert(std::end(buffer_), bytes, bytes + sizeof(T));
+    }
+
+    void varint(uint32_t x) {
+        while (x >= 0x80) {
+            buffer_.push_back(static_cast<char>((x & 0x7F) | 0x80));
+            x >>= 7;
+        }
+
+        buffer_.push_back(static_cast<char>(x));
+    }
+
+    void rect(room_rect_set::rect_t const& r) {
+        (*this)(static_cast<int32_t>(r.left()));
+        (*this)(static_cast<int32_t>(r.top()));
+        (*this)(static_cast<int32_t>(r.right()));
+        (*this)(static_cast<int32_t>(r.bottom()));
+    }
+
+    std::vector<char> const& buffer() const BK_NOEXCEPT { return buffer_; }
+private:
+    std::vector<char> buffer_;
+};
+
+//------------------------------------------------------------------------------
+//! Reads from a buffer; every read past the end fails and leaves ok() false.
+//------------------------------------------------------------------------------
+class reader {
+public:
+    explicit reader(std::vector<char> const& buffer) : buffer_ (buffer) {}
+
+    template <typename T>
+    T read() {
+        static_assert(std::is_arithmetic<T>::value, "");
+
+        T result {};
+
+        if (!ok_ || buffer_.size() - pos_ < sizeof(T)) {
+            ok_ = false;
+            return result;
+        }
+
+        std::memcpy(&result, buffer_.data() + pos_, sizeof(T));
+        pos_ += sizeof(T);
+
+        return result;
+    }
+
+    uint32_t varint() {
+        uint32_t result = 0;
+
+        for (int shift = 0; shift < 32; shift += 7) {
+            auto const byte = read<uint8_t>();
+            result |= static_cast<uint32_t>(byte & 0x7F) << shift;
+
+            if (!(byte & 0x80)) {
+                return result;
+            }
+        }
+
+        ok_ = false;
+        return result;
+    }
+
+    room_rect_set::rect_t rect() {
+        auto const l = read<int32_t>();
+        auto const t = read<int32_t>();
+        auto const r = read<int32_t>();
+        auto const b = read<int32_t>();
+
+        return room_rect_set::rect_t {l, t, r, b};
+    }
+
+    bool ok()   const BK_NOEXCEPT { return ok_; }
+    bool done() const BK_NOEXCEPT { return pos_ == buffer_.size(); }
+private:
+    std::vector<char> const& buffer_;
+    size_t                   pos_ = 0;
+    bool                     ok_  = true;
+};
+
+bool same_tile(tile_data const& a, tile_data const& b) BK_NOEXCEPT {
+    return a.type == b.type && a.sub_type == b.sub_type && a.room_id == b.room_id;
+}
+
+std::vector<char> encode(level_cache::key_t const key, level const& lvl) {
+    writer out;
+
+    for (auto const c : MAGIC) {
+        out(c);
+    }
+
+    out(FORMAT_VERSION);
+    out(key);
+
+    out(static_cast<uint32_t>(lvl.room_defs_.size()));
+    for (auto const& room : lvl.room_defs_) {
+        out(static_cast<uint32_t>(room.size()));
+        for (auto const& value : room) {
+            out.rect(value.base);
+            out(static_cast<uint8_t>(value.has_hole ? 1 : 0));
+            if (value.has_hole) {
+                out.rect(value.hole);
+            }
+        }
+    }
+
+    auto const& grid  = lvl.grid_;
+    auto const& tiles = grid.tiles_;
+
+    out(static_cast<uint32_t>(grid.width()));
+    out(static_cast<uint32_t>(grid.height()));
+
+    uint32_t runs = 0;
+    for (size_t i = 0; i < tiles.size(); ++runs) {
+        auto j = i + 1;
+        while (j < tiles.size() && same_tile(tiles[i], tiles[j])) ++j;
+        i = j;
+    }
+
+    out(runs);
+
+    for (size_t i = 0; i < tiles.size(); ) {
+        auto j = i + 1;
+        while (j < tiles.size() && same_tile(tiles[i], tiles[j])) ++j;
+
+        out.varint(static_cast<uint32_t>(j - i));
+        out.varint(static_cast<uint32_t>(tiles[i].type));
+        out.varint(tiles[i].sub_type);
+        out.varint(tiles[i].room_id);
+
+        i = j;
+    }
+
+    return out.buffer();
+}
+
+bool decode(
+    std::vector<char> const& buffer
+  , level_cache::key_t const key
+  , level_cache::params_t const& params
+  , level& out
+) {
+    reader in {buffer};
+
+    for (auto const c : MAGIC) {
+        if (in.read<char>() != c) return false;
+    }
+
+    if (in.read<uint32_t>() != FORMAT_VERSION || in.read<uint64_t>() != key) {
+        return false;
+    }
+
+    std::vector<room_rect_set> rooms;
+
+    auto const room_count = in.read<uint32_t>();
+    for (uint32_t i = 0; in.ok() && i < room_count; ++i) {
+        auto const rect_count = in.read<uint32_t>();
+        if (rect_count == 0) {
+            return false;
+        }
+
+        for (uint32_t j = 0; in.ok() && j < rect_count; ++j) {
+            auto const base     = in.rect();
+            auto const has_hole = in.read<uint8_t>() != 0;
+
+            if (j == 0) {
+                rooms.emplace_back(base);
+            } else {
+                rooms.back().add(base);
+            }
+
+            if (has_hole) {
+                auto& room = rooms.back();
+                room.begin()[j].has_hole = true;
+                room.begin()[j].hole     = in.rect();
+            }
+        }
+    }
+
+    auto const w    = in.read<uint32_t>();
+    auto const h    = in.read<uint32_t>();
+    auto const runs = in.read<uint32_t>();
+
+    //every run is at least one tile
+    if (!in.ok()
+     || static_cast<int>(w) != params.field_w
+     || static_cast<int>(h) != params.field_h
+     || runs > static_cast<size_t>(w) * h
+    ) {
+        return false;
+    }
+
+    tile_grid grid {w, h};
+    auto& tiles = grid.tiles_;
+
+    size_t i = 0;
+    for (uint32_t r = 0; r < runs; ++r) {
+        auto const length = in.varint();
+
+        tile_data tile;
+        tile.type     = static_cast<tile_data::tile_type>(in.varint());
+        tile.sub_type = static_cast<tile_data::tile_sub_type>(in.varint());
+        tile.room_id  = static_cast<tile_data::room_id_t>(in.varint());
+
+        if (!in.ok() || length == 0 || length > tiles.size() - i) {
+            return false;
+        }
+
+        std::fill_n(tiles.begin() + i, length, tile);
+        i += length;
+    }
+
+    if (i != tiles.size() || !in.done()) {
+        return false;
+    }
+
+    out = level {params, std::move(rooms), std::move(grid)};
+
+    return true;
+}
+
+bool read_file(std::string const& path, std::vector<char>& out) {
+    std::ifstream in {path, std::ios::binary};
+    if (!in) {
+        return false;
+    }
+
+    in.seekg(0, std::ios::end);
+    auto const size = in.tellg();
+    in.seekg(0, std::ios::beg);
+
+    if (size < 0) {
+        return false;
+    }
+
+    out.resize(static_cast<size_t>(size));
+    in.read(out.data(), size);
+
+    return static_cast<bool>(in);
+}
+
+//------------------------------------------------------------------------------
+//! A name for a temporary file unique to this call: other threads and other
+//! processes sharing the directory each get their own.
+//------------------------------------------------------------------------------
+std::string temp_suffix() {
+    static std::atomic<uint32_t> counter {0};
+
+#if BOOST_OS_WINDOWS
+    auto const pid = _getpid();
+#else
+    auto const pid = getpid();
+#endif
+
+    return "." + std::to_string(pid) + "." + std::to_string(counter++) + ".tmp";
+}
+
+void make_directory(std::string const& path) {
+#if BOOST_OS_WINDOWS
+    _mkdir(path.c_str());
+#else
+    mkdir(path.c_str(), 0755);
+#endif
+}
+
+#if BOOST_OS_WINDOWS
+std::wstring widen(std::string const& utf8) {
+    return std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> {}.from_bytes(utf8);
+}
+
+std::string narrow(std::wstring const& utf16) {
+    return std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> {}.to_bytes(utf16);
+}
+#endif
+
+//------------------------------------------------------------------------------
+//! Move @p from over @p to in one step: a reader of @p to sees either the old
+//! file or the new one, never no file.
+//------------------------------------------------------------------------------
+bool replace_file(std::string const& from, std::string const& to) {
+#if BOOST_OS_WINDOWS
+    return ::MoveFileExW(widen(from).c_str(), widen(to).c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+//! the names of the files in @p directory.
+std::vector<std::string> list_directory(std::string const& directory) {
+    std::vector<std::string> result;
+
+#if BOOST_OS_WINDOWS
+    WIN32_FIND_DATAW data;
+
+    auto const find = ::FindFirstFileW(widen(directory + "/*").c_str(), &data);
+    if (find == INVALID_HANDLE_VALUE) {
+        return result;
+    }
+
+    do {
+        if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+            result.push_back(narrow(data.cFileName));
+        }
+    } while (::FindNextFileW(find, &data));
+
+    ::FindClose(find);
+#else
+    auto const dir = ::opendir(directory.c_str());
+    if (!dir) {
+        return result;
+    }
+
+    while (auto const entry = ::readdir(dir)) {
+        result.emplace_back(entry->d_name);
+    }
+
+    ::closedir(dir);
+#endif
+
+    return result;
+}
+
+//------------------------------------------------------------------------------
+//! The key of a level file name ("<16 hex digits>.lvl").
+//! @returns false if @p name is not one.
+//------------------------------------------------------------------------------
+bool key_of_name(std::string const& name, level_cache::key_t& key) {
+    auto const digits = size_t {16};
+
+    if (name.size() != digits + sizeof(FILE_EXTENSION) - 1
+     || name.compare(digits, std::string::npos, FILE_EXTENSION) != 0
+     || !std::all_of(name.begin(), name.begin() + digits, [](char const c) {
+            return std::isxdigit(static_cast<unsigned char>(c)) != 0;
+        })
+    ) {
+        return false;
+    }
+
+    key = std::stoull(name.substr(0, digits), nullptr, 16);
+    return true;
+}
+
+//! the size of the file at @p path; 0 if it cannot be read.
+size_t file_size(std::string const& path) {
+    std::ifstream in {path, std::ios::binary | std::ios::ate};
+    auto const size = in ? static_cast<std::streamoff>(in.tellg()) : 0;
+    return size > 0 ? static_cast<size_t>(size) : 0;
+}
+
+} //namespace
+
+level_cache::level_cache(std::string directory, size_t const max_bytes)
+  : directory_ (std::move(directory))
+  , max_bytes_ {max_bytes}
+{
+    make_directory(directory_);
+    read_index_();
+
+    std::lock_guard<std::mutex> lock {mutex_};
+    evict_();
+}
+
+level_cache::~level_cache() {
+    write_index_();
+}
+
+level_cache::key_t level_cache::key_of(uint64_t const seed, params_t const& params) {
+    hasher h;
+
+    h(LEVEL_GENERATOR_VERSION);
+    h(seed);
+
+    h(params.cell_size);
+    h(params.rect_min_size);
+    h(params.rect_max_size);
+    h(params.rect_size_mean);
+    h(params.rect_size_stddev);
+    h(params.rects_per_cell_mean);
+    h(params.rects_per_cell_stddev);
+    h(params.hole_probability);
+    h(params.field_w);
+    h(params.field_h);
+    h(params.cells_w);
+    h(params.cells_h);
+
+    return h.value;
+}
+
+bool level_cache::load(key_t const key, level& out) {
+    uint64_t version = 0;
+
+    {
+        std::lock_guard<std::mutex> lock {mutex_};
+
+        auto const where = index_.find(key);
+        if (where == std::end(index_)) {
+            ++misses_;
+            return false;
+        }
+
+        version = where->second.version;
+    }
+
+    std::vector<char> buffer;
+    auto const ok = read_file(path_of_(key), buffer)
+                 && decode(buffer, key, out.params_, out);
+
+    std::lock_guard<std::mutex> lock {mutex_};
+
+    //may have been evicted, or stored again, by another thread while reading;
+    //only the file this call looked at is dropped or touched
+    auto const where   = index_.find(key);
+    auto const current = where != std::end(index_) && where->second.version == version;
+
+    if (!ok) {
+        ++misses_;
+        if (current) {
+            erase_(key);
+        }
+        return false;
+    }
+
+    ++hits_;
+
+    if (current) {
+        touch_(key, buffer.size(), version);
+    }
+
+    return true;
+}
+
+void level_cache::store(key_t const key, level const& lvl) {
+    auto const buffer = encode(key, lvl);
+    auto const path   = path_of_(key);
+
+    //write to a temporary first so readers never see a partial file
+    auto const tmp = path + temp_suffix();
+
+    {
+        std::ofstream out {tmp, std::ios::binary};
+        out.write(buffer.data(), buffer.size());
+
+        if (!out) {
+            std::remove(tmp.c_str());
+            return;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock {mutex_};
+
+    if (!replace_file(tmp, path)) {
+        std::remove(tmp.c_str());
+        return;
+    }
+
+    touch_(key, buffer.size(), ++next_version_);
+    evict_();
+}
+
+void level_cache::clear() {
+    std::lock_guard<std::mutex> lock {mutex_};
+
+    while (!lru_.empty()) {
+        erase_(lru_.back());
+    }
+
+    std::remove(index_path_().c_str());
+}
+
+void level_cache::flush() const {
+    write_index_();
+}
+
+size_t level_cache::size() const {
+    std::lock_guard<std::mutex> lock {mutex_};
+    return index_.size();
+}
+
+size_t level_cache::bytes() const {
+    std::lock_guard<std::mutex> lock {mutex_};
+    return bytes_;
+}
+
+size_t level_cache::hits() const {
+    std::lock_guard<std::mutex> lock {mutex_};
+    return hits_;
+}
+
+size_t level_cache::misses() const {
+    std::lock_guard<std::mutex> lock {mutex_};
+    return misses_;
+}
+
+std::string level_cache::path_of_(key_t const key) const {
+    std::ostringstream name;
+    name << directory_ << "/" << std::hex << std::setw(16) << std::setfill('0') << key
+         << FILE_EXTENSION;
+
+    return name.str();
+}
+
+std::string level_cache::index_path_() const {
+    return directory_ + "/" + INDEX_NAME;
+}
+
+//------------------------------------------------------------------------------
+// index: one "<key> <bytes>" per line, most recently used first.
+//
+// The index is only as new as the last flush; the files in the directory are
+// the truth. Indexed levels whose file is gone are dropped, and files the
+// index does not know (stored since the last flush, before a crash) are added
+// as the least recently used.
+//------------------------------------------------------------------------------
+void level_cache::read_index_() {
+    std::ifstream in {index_path_()};
+
+    std::lock_guard<std::mutex> lock {mutex_};
+
+    std::unordered_map<key_t, size_t> files;
+    for (auto const& name : list_directory(directory_)) {
+        key_t key;
+        if (key_of_name(name, key)) {
+            files[key] = file_size(directory_ + "/" + name);
+        }
+    }
+
+    auto const add = [&](key_t const key, size_t const bytes) {
+        lru_.push_back(key);
+        index_[key] = entry_t {bytes, std::prev(std::end(lru_)), ++next_version_};
+        bytes_ += bytes;
+    };
+
+    key_t  key;
+    size_t bytes;
+
+    while (in >> std::hex >> key >> std::dec >> bytes) {
+        auto const where = files.find(key);
+        if (where == std::end(files) || index_.find(key) != std::end(index_)) {
+            continue;
+        }
+
+        add(key, where->second);
+    }
+
+    for (auto const& file : files) {
+        if (index_.find(file.first) == std::end(index_)) {
+            add(file.first, file.second);
+        }
+    }
+}
+
+void level_cache::write_index_() const {
+    std::lock_guard<std::mutex> lock {mutex_};
+
+    std::ofstream out {index_path_()};
+
+    for (auto const key : lru_) {
+        out << std::hex << key << " " << std::dec << index_.at(key).bytes << "\n";
+    }
+}
+
+void level_cache::touch_(key_t const key, size_t const bytes, uint64_t const version) {
+    auto const where = index_.find(key);
+
+    if (where != std::end(index_)) {
+        bytes_ -= where->second.bytes;
+        lru_.erase(where->second.where);
+    }
+
+    lru_.push_front(key);
+    index_[key] = entry_t {bytes, std::begin(lru_), version};
+    bytes_ += bytes;
+}
+
+void level_cache::erase_(key_t const key) {
+    auto const where = index_.find(key);
+    BK_ASSERT(where != std::end(index_));
+
+    bytes_ -= where->second.bytes;
+    lru_.erase(where->second.where);
+    index_.erase(where);
+
+    std::remove(path_of_(key).c_str());
+}
+
+void level_cache::evict_() {
+    while (bytes_ > max_bytes_ && !lru_.empty()) {
+        erase_(lru_.back());
+    }
+}
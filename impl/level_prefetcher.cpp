@@ -0,0 +1,197 @@
+#include "level_prefetcher.hpp"
+
+using tez::level_prefetcher;
+
+level_prefetcher::level_prefetcher(
+    uint64_t const world_seed
+  , params_t const params
+  , size_t   const capacity
+  , unsigned const threads
+  , level_cache* const cache
+)
+  : world_seed_ {world_seed}
+  , params_     {params}
+  , capacity_   {capacity}
+  , cache_      {cache}
+{
+    auto const n = tez::worker_count(threads);
+
+    workers_.reserve(n);
+    for (unsigned i = 0; i < n; ++i) {
+        workers_.emplace_back([this] { work_(); });
+    }
+}
+
+level_prefetcher::~level_prefetcher() {
+    {
+        std::lock_guard<std::mutex> lock {mutex_};
+        stop_ = true;
+        queue_.clear();
+    }
+
+    work_cv_.notify_all();
+
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+bool level_prefetcher::prefetch(depth_t const depth) {
+    {
+        std::lock_guard<std::mutex> lock {mutex_};
+
+        auto const where = slots_.find(depth);
+        if (where != std::end(slots_)) {
+            //a cancelled level still in progress is wanted again
+            where->second.cancelled = false;
+            return false;
+        }
+
+        if (slots_.size() >= capacity_) {
+            return false;
+        }
+
+        slots_.emplace(depth, slot_t {});
+        queue_.push_back(depth);
+    }
+
+    work_cv_.notify_one();
+
+    return true;
+}
+
+void level_prefetcher::retain(std::initializer_list<depth_t> const depths) {
+    auto const keep = [&](depth_t const depth) {
+        return std::find(std::begin(depths), std::end(depths), depth) != std::end(depths);
+    };
+
+    std::lock_guard<std::mutex> lock {mutex_};
+
+    queue_.erase(
+        std::remove_if(std::begin(queue_), std::end(queue_), [&](depth_t const depth) {
+            return !keep(depth);
+        })
+      , std::end(queue_)
+    );
+
+    for (auto it = std::begin(slots_); it != std::end(slots_); ) {
+        if (keep(it->first)) {
+            ++it;
+        } else if (it->second.state == state_t::running) {
+            it->second.cancelled = true;
+            ++it;
+        } else {
+            it = slots_.erase(it);
+        }
+    }
+}
+
+level level_prefetcher::take(depth_t const depth) {
+    std::unique_lock<std::mutex> lock {mutex_};
+
+    auto where = slots_.find(depth);
+
+    if (where != std::end(slots_) && where->second.state == state_t::queued) {
+        //not started yet; cheaper to do it here than to wait for a worker
+        queue_.erase(std::find(std::begin(queue_), std::end(queue_), depth));
+        slots_.erase(where);
+        where = std::end(slots_);
+    }
+
+    if (where == std::end(slots_)) {
+        lock.unlock();
+        return generate_(depth, params_);
+    }
+
+    where->second.cancelled = false;
+
+    done_cv_.wait(lock, [&] {
+        auto const it = slots_.find(depth);
+        return it == std::end(slots_) || it->second.state == state_t::ready;
+    });
+
+    where = slots_.find(depth);
+
+    if (where == std::end(slots_)) {
+        //cancelled again while waiting
+        lock.unlock();
+        return generate_(depth, params_);
+    }
+
+    auto const error  = where->second.error;
+    auto       result = std::move(where->second.result);
+    slots_.erase(where);
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    return std::move(*result);
+}
+
+size_t level_prefetcher::size() const {
+    std::lock_guard<std::mutex> lock {mutex_};
+    return slots_.size();
+}
+
+level level_prefetcher::generate_(depth_t const depth, params_t const& params) const {
+    auto const index = static_cast<uint64_t>(depth);
+
+    auto const generate = [&] {
+        auto random = tez::make_stream(world_seed_, index);
+        return level {random, params};
+    };
+
+    if (!cache_) {
+        return generate();
+    }
+
+    return cache_->fetch(tez::derive_seed(world_seed_, index), params, generate);
+}
+
+void level_prefetcher::work_() {
+    //the result does not depend on the thread count, so keep background
+    //generation to this thread and leave the other cores alone.
+    auto params = params_;
+    params.thread_count = 1;
+
+    std::unique_lock<std::mutex> lock {mutex_};
+
+    for (;;) {
+        work_cv_.wait(lock, [&] { return stop_ || !queue_.empty(); });
+
+        if (stop_) {
+            return;
+        }
+
+        auto const depth = queue_.front();
+        queue_.pop_front();
+
+        slots_[depth].state = state_t::running;
+
+        std::unique_ptr<level> result;
+        std::exception_ptr     error;
+
+        lock.unlock();
+        try {
+            result = std::make_unique<level>(generate_(depth, params));
+        } catch (...) {
+            //kept for take(); the worker itself carries on
+            error = std::current_exception();
+        }
+        lock.lock();
+
+        auto const where = slots_.find(depth);
+        BK_ASSERT(where != std::end(slots_));
+
+        if (where->second.cancelled) {
+            slots_.erase(where);
+        } else {
+            where->second.result = std::move(result);
+            where->second.error  = error;
+            where->second.state  = state_t::ready;
+        }
+
+        done_cv_.notify_all();
+    }
+}
@@ -0,0 +1,169 @@
+#include "level_stats.hpp"
+
+using tez::level_stats;
+using tez::level_limits;
+
+namespace {
+
+bool is_walkable(tile_data const& tile) BK_NOEXCEPT {
+    return tile.type == tile_data::tile_type::floor
+        || tile.type == tile_data::tile_type::corridor;
+}
+
+//------------------------------------------------------------------------------
+//! The number of pairs of distinct rooms with overlapping rects.
+//------------------------------------------------------------------------------
+size_t count_overlapping_rooms(std::vector<room_rect_set> const& rooms) {
+    std::vector<room_rect_set::rect_t> rects;
+    std::vector<size_t>                owners;
+
+    for (size_t i = 0; i < rooms.size(); ++i) {
+        for (auto const& value : rooms[i]) {
+            rects.push_back(value.base);
+            owners.push_back(i);
+        }
+    }
+
+    std::vector<std::pair<size_t, size_t>> pairs;
+
+    bklib::for_each_intersecting_pair(rects, [&](size_t const a, size_t const b) {
+        auto const i = owners[a];
+        auto const j = owners[b];
+
+        if (i != j) {
+            pairs.emplace_back(std::min(i, j), std::max(i, j));
+        }
+    });
+
+    std::sort(std::begin(pairs), std::end(pairs));
+
+    return static_cast<size_t>(
+        std::unique(std::begin(pairs), std::end(pairs)) - std::begin(pairs)
+    );
+}
+
+} //namespace
+
+level_stats tez::analyze(level const& lvl) {
+    using tile_type = tile_data::tile_type;
+
+    level_stats result;
+
+    auto const& grid = lvl.grid_;
+    auto const  w    = grid.width();
+    auto const  h    = grid.height();
+
+    result.tiles = w * h;
+
+    //--------------------------------------------------------------------------
+    // one sweep: count tiles, find dead ends, and join each walkable tile with
+    // its walkable west and north neighbors.
+    //--------------------------------------------------------------------------
+    bklib::disjoint_set sets {w * h};
+    std::vector<size_t> sizes(w * h, 0);
+
+    auto const join = [&](size_t const a, size_t const b) {
+        auto const ra = sets.find(a);
+        auto const rb = sets.find(b);
+
+        if (ra != rb) {
+            sets.unite(ra, rb);
+            sizes[sets.find(ra)] = sizes[ra] + sizes[rb];
+        }
+    };
+
+    for (size_t y = 0; y < h; ++y) {
+        for (size_t x = 0; x < w; ++x) {
+            auto const& tile = grid.at(x, y);
+            if (!is_walkable(tile)) {
+                continue;
+            }
+
+            auto const i = y * w + x;
+            sizes[i] = 1;
+
+            if (tile.type == tile_type::floor) {
+                ++result.floor_tiles;
+            } else {
+                ++result.corridor_tiles;
+
+                auto const neighbors =
+                    (x > 0     && is_walkable(grid.at(x - 1, y)) ? 1 : 0)
+                  + (x + 1 < w && is_walkable(grid.at(x + 1, y)) ? 1 : 0)
+                  + (y > 0     && is_walkable(grid.at(x, y - 1)) ? 1 : 0)
+                  + (y + 1 < h && is_walkable(grid.at(x, y + 1)) ? 1 : 0);
+
+                if (neighbors == 1) {
+                    ++result.dead_ends;
+                }
+            }
+
+            if (x > 0 && is_walkable(grid.at(x - 1, y))) {
+                join(i, i - 1);
+            }
+
+            if (y > 0 && is_walkable(grid.at(x, y - 1))) {
+                join(i, i - w);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        if (sizes[i] && sets.find(i) == i) {
+            result.component_sizes.push_back(sizes[i]);
+        }
+    }
+
+    std::sort(
+        std::begin(result.component_sizes), std::end(result.component_sizes)
+      , std::greater<size_t> {}
+    );
+
+    //--------------------------------------------------------------------------
+    // rooms
+    //--------------------------------------------------------------------------
+    auto const& rooms = lvl.room_defs_;
+
+    result.room_count        = rooms.size();
+    result.overlapping_rooms = count_overlapping_rooms(rooms);
+
+    for (size_t i = 0; i < rooms.size(); ++i) {
+        auto const area = room_polygon {rooms[i]}.area();
+
+        if (i == 0 || area < result.min_room_area) {
+            result.min_room_area = area;
+        }
+    }
+
+    return result;
+}
+
+uint32_t tez::find_defects(level_stats const& stats, level_limits const& limits) {
+    uint32_t result = LEVEL_OK;
+
+    if (stats.floor_ratio() < limits.min_floor_ratio) {
+        result |= LEVEL_SPARSE;
+    }
+
+    if (stats.room_count < limits.min_rooms) {
+        result |= LEVEL_TOO_FEW_ROOMS;
+    }
+
+    if (stats.room_count && stats.min_room_area < limits.min_room_area) {
+        result |= LEVEL_TINY_ROOM;
+    }
+
+    if (stats.component_sizes.size() > limits.max_components) {
+        result |= LEVEL_DISCONNECTED;
+    }
+
+    if (stats.overlapping_rooms > limits.max_overlapping_rooms) {
+        result |= LEVEL_OVERLAPPING_ROOMS;
+    }
+
+    if (stats.dead_ends > limits.max_dead_ends) {
+        result |= LEVEL_DEAD_ENDS;
+    }
+
+    return result;
+}
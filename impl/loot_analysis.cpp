@@ -0,0 +1,246 @@
+#include "loot_analysis.hpp"
+
+using tez::loot_analyzer;
+using tez::loot_item_rate;
+using tez::loot_rates;
+using tez::loot_table;
+using tez::distribution;
+using tez::item_ref;
+
+namespace {
+
+//! below this, tails of unbounded distributions are dropped.
+double const EPSILON = 1e-12;
+
+//! the standard normal cdf.
+double phi(double const x) {
+    return 0.5 * std::erfc(-x / std::sqrt(2.0));
+}
+
+void add_count(std::vector<double>& result, int const count, double const p) {
+    auto const i = static_cast<size_t>(count > 0 ? count : 0);
+    if (result.size() <= i) {
+        result.resize(i + 1, 0.0);
+    }
+
+    result[i] += p;
+}
+
+//! the pmf at count k of a distribution whose log pmf is log_pmf(k), for k
+//! from 0 up to the point past mode where it falls below EPSILON.
+template <typename LogPmf>
+void add_tail(std::vector<double>& result, int const mode, int const last, LogPmf log_pmf) {
+    for (int k = 0; k <= last; ++k) {
+        auto const p = std::exp(log_pmf(k));
+        if (k > mode && p < EPSILON) {
+            break;
+        }
+
+        add_count(result, k, p);
+    }
+}
+
+struct entry_t {
+    double              probability; //of picking the entry
+    double              expected;    //count; counts <= 0 are 0
+    std::vector<double> counts;      //see count_probabilities
+};
+
+loot_item_rate const* find_rate(loot_rates const& rates, item_ref const item) {
+    auto const where = std::lower_bound(std::begin(rates), std::end(rates), item
+      , [](loot_item_rate const& r, item_ref const i) { return r.item < i; });
+
+    return (where != std::end(rates) && where->item == item) ? &*where : nullptr;
+}
+
+} //namespace
+
+std::vector<double> tez::count_probabilities(distribution const& dist) {
+    using kind = distribution::kind;
+
+    std::vector<double> result;
+
+    switch (dist.type()) {
+    case kind::fixed :
+        add_count(result, dist.fixed(), 1.0);
+        break;
+    case kind::uniform : {
+        auto const u = dist.uniform();
+        auto const n = static_cast<double>(u.max) - u.min + 1.0;
+
+        //everything <= 0 at once
+        if (u.min <= 0) {
+            auto const hi = std::min(u.max, 0);
+            add_count(result, 0, (static_cast<double>(hi) - u.min + 1.0) / n);
+        }
+
+        for (auto k = std::max(u.min, 1); k > 0 && k <= u.max; ++k) {
+            add_count(result, k, 1.0 / n);
+            if (k == u.max) {
+                break;
+            }
+        }
+
+        break;
+    }
+    case kind::normal : {
+        auto const d      = dist.normal();
+        auto const mean   = static_cast<double>(d.mean);
+        auto const stddev = static_cast<double>(d.stddev);
+
+        if (stddev <= 0.0) {
+            add_count(result, static_cast<int>(std::round(mean)), 1.0);
+            break;
+        }
+
+        //rounding is to nearest: k covers [k - 1/2, k + 1/2)
+        auto const cdf = [&](double const x) { return phi((x - mean) / stddev); };
+
+        add_count(result, 0, cdf(0.5));
+
+        auto const last = static_cast<int>(std::ceil(mean + 10.0 * stddev));
+        for (int k = 1; k <= last; ++k) {
+            auto const p = cdf(k + 0.5) - cdf(k - 0.5);
+            if (k > mean && p < EPSILON) {
+                break;
+            }
+
+            add_count(result, k, p);
+        }
+
+        break;
+    }
+    case kind::binomial : {
+        auto const d = dist.binomial();
+        auto const n = d.trials;
+        auto const p = static_cast<double>(d.p);
+
+        if (p <= 0.0 || n == 0) { add_count(result, 0, 1.0); break; }
+        if (p >= 1.0)           { add_count(result, n, 1.0); break; }
+
+        auto const mode = static_cast<int>(n * p);
+
+        add_tail(result, mode, n, [&](int const k) {
+            return std::lgamma(n + 1.0) - std::lgamma(k + 1.0) - std::lgamma(n - k + 1.0)
+                 + k * std::log(p) + (n - k) * std::log1p(-p);
+        });
+
+        break;
+    }
+    case kind::poisson : {
+        auto const mean = static_cast<double>(dist.poisson().mean);
+
+        if (mean <= 0.0) {
+            add_count(result, 0, 1.0);
+            break;
+        }
+
+        auto const mode = static_cast<int>(mean);
+        auto const last = static_cast<int>(mean + 12.0 * std::sqrt(mean) + 20.0);
+
+        add_tail(result, mode, last, [&](int const k) {
+            return k * std::log(mean) - mean - std::lgamma(k + 1.0);
+        });
+
+        break;
+    }
+    }
+
+    return result;
+}
+
+loot_rates const& loot_analyzer::operator()(loot_table const& table) {
+    auto const found = memo_.find(&table);
+    if (found != std::end(memo_)) {
+        return found->second;
+    }
+
+    auto const& entries = table.entries();
+    auto const& picker  = table.picker();
+
+    BK_ASSERT(picker.size() == entries.size());
+
+    auto const picked = entries.empty()
+      ? std::vector<double> {}
+      : alias_table::probabilities(picker.data(), picker.size());
+
+    //the entries, and the items any of them can drop
+    std::vector<entry_t>  info;
+    std::vector<item_ref> items;
+
+    info.reserve(entries.size());
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+        auto const& entry = entries[i];
+
+        entry_t e {picked[i], 0.0, count_probabilities(entry.count)};
+        for (size_t k = 1; k < e.counts.size(); ++k) {
+            e.expected += k * e.counts[k];
+        }
+
+        info.push_back(std::move(e));
+
+        if (auto const item = boost::get<item_ref>(&entry.value)) {
+            items.push_back(*item);
+        } else if (entry.table) {
+            //references to elements of memo_ survive the inserts this makes
+            for (auto const& r : (*this)(*entry.table)) {
+                items.push_back(r.item);
+            }
+        }
+    }
+
+    std::sort(std::begin(items), std::end(items));
+    items.erase(std::unique(std::begin(items), std::end(items)), std::end(items));
+
+    loot_rates result;
+    result.reserve(items.size());
+
+    for (auto const item : items) {
+        double expected = 0.0;
+        double none     = 0.0; //the chance of dropping none
+
+        for (size_t i = 0; i < entries.size(); ++i) {
+            auto const& entry = entries[i];
+            auto const& e     = info[i];
+
+            if (auto const value = boost::get<item_ref>(&entry.value)) {
+                if (*value == item) {
+                    expected += e.probability * e.expected;
+                    none     += e.probability * e.counts[0];
+                } else {
+                    none     += e.probability;
+                }
+
+                continue;
+            }
+
+            auto const child = entry.table ? find_rate(memo_.at(entry.table), item) : nullptr;
+            if (!child) {
+                none += e.probability;
+                continue;
+            }
+
+            //E[sum of count rolls] = E[count] * E[one roll];
+            //P(none in count rolls) = sum_k P(count = k) * P(none in one)^k
+            auto const q = 1.0 - child->probability;
+
+            double none_given_count = 0.0;
+            for (auto k = e.counts.size(); k-- > 0; ) {
+                none_given_count = none_given_count * q + e.counts[k];
+            }
+
+            expected += e.probability * e.expected * child->expected;
+            none     += e.probability * none_given_count;
+        }
+
+        result.push_back(loot_item_rate {item, expected, std::max(0.0, 1.0 - none)});
+    }
+
+    return memo_[&table] = std::move(result);
+}
+
+loot_item_rate loot_analyzer::rate(loot_table const& table, item_ref const item) {
+    auto const found = find_rate((*this)(table), item);
+    return found ? *found : loot_item_rate {item, 0.0, 0.0};
+}
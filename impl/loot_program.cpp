@@ -0,0 +1,180 @@
+#include "loot_program.hpp"
+
+using tez::loot_program;
+using tez::loot_table;
+using tez::item_ref;
+using tez::random_t;
+
+uint32_t const loot_program::NO_TABLE;
+
+loot_program::loot_program(loot_table_table::container_t const& tables) {
+    //tables keep their order in the container
+    std::unordered_map<loot_table const*, uint32_t> indices;
+    indices.reserve(tables.size());
+
+    for (auto const& value : tables) {
+        auto const i = static_cast<uint32_t>(indices.size());
+        indices.emplace(&value.second, i);
+        index_.emplace_hint(index_.end(), value.first, i);
+    }
+
+    tables_.reserve(tables.size());
+
+    for (auto const& value : tables) {
+        auto const& table   = value.second;
+        auto const& entries = table.entries();
+        auto const& picker  = table.picker();
+
+        BK_ASSERT(picker.size() == entries.size());
+
+        auto const first = static_cast<uint32_t>(code_.size());
+        tables_.push_back(table_t {first, static_cast<uint32_t>(entries.size())});
+
+        slots_.insert(std::end(slots_), picker.data(), picker.data() + picker.size());
+
+        for (auto const& entry : entries) {
+            instruction in;
+            in.count = entry.count;
+
+            if (auto const item = boost::get<item_ref>(&entry.value)) {
+                in.code = op::emit;
+                in.item = *item;
+            } else if (entry.table) {
+                auto const where = indices.find(entry.table);
+                BK_ASSERT(where != std::end(indices));
+
+                in.code  = op::repeat;
+                in.table = where->second;
+            } else {
+                in.code = op::skip;
+            }
+
+            code_.push_back(in);
+        }
+    }
+}
+
+uint32_t loot_program::find(hash_wrapper<detail::tag_loot_table> const ref) const {
+    auto const where = index_.find(loot_table_ref {ref.value});
+    return where != std::end(index_) ? where->second : NO_TABLE;
+}
+
+template <typename Emit>
+void loot_program::run_(
+    uint32_t const table
+  , random_t&      random
+  , stack_t&       stack
+  , Emit&&         emit
+) const {
+    BK_ASSERT(table < tables_.size());
+
+    stack.clear();
+
+    //the innermost frame lives in locals; the stack holds the frames below it
+    auto current   = table;
+    auto remaining = 1;
+
+    for (;;) {
+        if (remaining <= 0) {
+            if (stack.empty()) {
+                break;
+            }
+
+            current   = stack.back().table;
+            remaining = stack.back().remaining;
+            stack.pop_back();
+
+            continue;
+        }
+
+        --remaining;
+
+        auto const& t = tables_[current];
+        if (t.size == 0) {
+            continue;
+        }
+
+        auto const  i  = alias_table::pick(slots_.data() + t.first, t.size, random);
+        auto const& in = code_[t.first + i];
+
+        auto const count = in.count(random);
+
+        switch (in.code) {
+        case op::emit :
+            if (count > 0) {
+                emit(in.item, count);
+            }
+            break;
+        case op::repeat :
+            if (count > 0) {
+                if (remaining > 0) {
+                    stack.push_back(frame {current, remaining});
+                }
+
+                current   = in.table;
+                remaining = count;
+            }
+            break;
+        case op::skip :
+            break;
+        }
+    }
+}
+
+void loot_program::roll(
+    uint32_t const table
+  , random_t&      random
+  , item_list&     items
+  , stack_t&       stack
+) const {
+    run_(table, random, stack, [&](item_ref const item, int const count) {
+        items.insert(std::end(items), static_cast<size_t>(count), item);
+    });
+}
+
+void loot_program::roll(
+    uint32_t const table
+  , size_t const   times
+  , random_t&      random
+  , loot_batch&    out
+) const {
+    for (size_t i = 0; i < times; ++i) {
+        roll_once_(table, random, out);
+    }
+}
+
+void loot_program::roll(
+    uint32_t const* const tables
+  , size_t const          count
+  , random_t&             random
+  , loot_batch&           out
+) const {
+    for (size_t i = 0; i < count; ++i) {
+        roll_once_(tables[i], random, out);
+    }
+}
+
+void loot_program::roll_once_(uint32_t const table, random_t& random, loot_batch& out) const {
+    auto& drops = out.drops;
+    auto const first = drops.size();
+
+    run_(table, random, out.stack, [&](item_ref const item, int const count) {
+        //join consecutive drops of the same item within a roll
+        if (drops.size() > first && drops.back().item == item) {
+            drops.back().count += count;
+        } else {
+            drops.push_back(loot_drop {item, count});
+        }
+    });
+
+    out.ends.push_back(static_cast<uint32_t>(drops.size()));
+}
+
+loot_program::item_list loot_program::roll(uint32_t const table, random_t& random) const {
+    item_list items;
+    stack_t   stack;
+
+    roll(table, random, items, stack);
+
+    return items;
+}
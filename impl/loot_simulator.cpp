@@ -0,0 +1,178 @@
+#include "loot_simulator.hpp"
+#include "parallel.hpp"
+
+using tez::loot_simulation;
+using tez::loot_table;
+using tez::item_ref;
+
+namespace {
+
+//! rolls per stream; fixed, so the streams do not depend on the thread count.
+uint64_t const CHUNK_SIZE = 4096;
+
+bool item_less(loot_simulation::item_t const& lhs, item_ref const rhs) {
+    return lhs.item < rhs;
+}
+
+loot_simulation::item_t& find_or_insert(loot_simulation& sim, item_ref const item) {
+    auto& items = sim.items;
+
+    auto const where = std::lower_bound(std::begin(items), std::end(items), item, item_less);
+    if (where != std::end(items) && where->item == item) {
+        return *where;
+    }
+
+    loot_simulation::item_t value;
+    value.item = item;
+
+    return *items.insert(where, std::move(value));
+}
+
+void add_count(loot_simulation::item_t& value, uint64_t const k, uint64_t const rolls) {
+    if (value.histogram.size() <= k) {
+        value.histogram.resize(static_cast<size_t>(k) + 1, 0);
+    }
+
+    value.histogram[static_cast<size_t>(k)] += rolls;
+}
+
+//! one worker's rolls; [0] of the histograms is filled in at the end.
+struct worker_t {
+    loot_simulation result;
+
+    loot_table::item_list items;
+    loot_table::history_t history;
+
+    void roll(loot_table const& table, tez::random_t& random) {
+        items.clear();
+        table.roll(random, items, history);
+
+        ++result.rolls;
+
+        std::sort(std::begin(items), std::end(items));
+
+        for (size_t i = 0; i < items.size(); ) {
+            auto j = i + 1;
+            while (j < items.size() && items[j] == items[i]) {
+                ++j;
+            }
+
+            auto& value = find_or_insert(result, items[i]);
+            value.total += j - i;
+            add_count(value, j - i, 1);
+
+            i = j;
+        }
+    }
+};
+
+} //namespace
+
+////////////////////////////////////////////////////////////////////////////////
+// tez::loot_simulation
+////////////////////////////////////////////////////////////////////////////////
+loot_simulation::item_t const* loot_simulation::find(item_ref const item) const {
+    auto const where = std::lower_bound(std::begin(items), std::end(items), item, item_less);
+    return (where != std::end(items) && where->item == item) ? &*where : nullptr;
+}
+
+double loot_simulation::expected(item_ref const item) const {
+    auto const value = find(item);
+    return (value && rolls) ? static_cast<double>(value->total) / rolls : 0.0;
+}
+
+double loot_simulation::probability(item_ref const item) const {
+    auto const value = find(item);
+    if (!value || !rolls) {
+        return 0.0;
+    }
+
+    auto const none = value->histogram.empty() ? 0 : value->histogram[0];
+    return static_cast<double>(rolls - none) / rolls;
+}
+
+void loot_simulation::merge(loot_simulation const& other) {
+    //items of this missing from other dropped none in all of other's rolls,
+    //and the other way round.
+    for (auto& value : items) {
+        if (!other.find(value.item)) {
+            add_count(value, 0, other.rolls);
+        }
+    }
+
+    for (auto const& value : other.items) {
+        auto const is_new = !find(value.item);
+        auto&      out    = find_or_insert(*this, value.item);
+
+        if (is_new) {
+            add_count(out, 0, rolls);
+        }
+
+        out.total += value.total;
+        for (size_t k = 0; k < value.histogram.size(); ++k) {
+            add_count(out, k, value.histogram[k]);
+        }
+    }
+
+    rolls += other.rolls;
+}
+
+bool tez::operator==(loot_simulation const& lhs, loot_simulation const& rhs) {
+    using item_t = loot_simulation::item_t;
+
+    return lhs.rolls == rhs.rolls
+        && lhs.items.size() == rhs.items.size()
+        && std::equal(std::begin(lhs.items), std::end(lhs.items), std::begin(rhs.items)
+             , [](item_t const& a, item_t const& b) {
+                 return a.item == b.item && a.total == b.total && a.histogram == b.histogram;
+             });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// tez::simulate_loot
+////////////////////////////////////////////////////////////////////////////////
+loot_simulation tez::simulate_loot(
+    loot_table const& table
+  , uint64_t const    rolls
+  , uint64_t const    seed
+  , unsigned const    threads
+) {
+    auto const chunks  = (rolls + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    auto const workers = std::min<uint64_t>(worker_count(threads), chunks ? chunks : 1);
+    auto const base    = derive_seed(seed, table.reference().value);
+
+    std::vector<worker_t> results(static_cast<size_t>(workers));
+    std::atomic<uint64_t> next {0};
+
+    //one call per worker; chunks are handed out dynamically.
+    parallel_for(results.size(), static_cast<unsigned>(workers), [&](size_t const w) {
+        auto& worker = results[w];
+
+        for (auto c = next++; c < chunks; c = next++) {
+            auto       random = make_stream(base, c);
+            auto const first  = c * CHUNK_SIZE;
+            auto const last   = std::min(first + CHUNK_SIZE, rolls);
+
+            for (auto i = first; i < last; ++i) {
+                worker.roll(table, random);
+            }
+        }
+
+        //rolls that dropped none of an item
+        for (auto& value : worker.result.items) {
+            uint64_t some = 0;
+            for (size_t k = 1; k < value.histogram.size(); ++k) {
+                some += value.histogram[k];
+            }
+
+            add_count(value, 0, worker.result.rolls - some);
+        }
+    });
+
+    loot_simulation result;
+    for (auto const& worker : results) {
+        result.merge(worker.result);
+    }
+
+    return result;
+}
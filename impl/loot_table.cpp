@@ -1,4 +1,5 @@
 #include "loot_table.hpp"
+#include "item.hpp"
 
 #include <bklib/assert.hpp>
 #include <bklib/util.hpp>
@@ -6,6 +7,8 @@
 
 using tez::loot_table;
 using tez::loot_table_parser;
+using tez::loot_link_error;
+using tez::loot_link_errors;
 using tez::distribution;
 using tez::loot_table_ref;
 using tez::item_ref;
@@ -20,19 +23,21 @@ using bklib::string_ref;
 ////////////////////////////////////////////////////////////////////////////////
 loot_table::loot_table(utf8string id, table_entries&& entries, weights_t const& weights)
   : entries_{std::move(entries)}
+  , picker_ {weights}
   , id_ {id}
-  , distribution_(
-        weights.size()
-      , double {0}
-      , static_cast<double>(weights.size())
-      , [&](double d) {
-            return weights[static_cast<size_t>(d)];
-        }
-    )
 {
+    BK_ASSERT(picker_.size() == entries_.size());
 }
 
-loot_table::item_list loot_table::roll(random_t& random) {
+loot_table::loot_table(utf8string id, table_entries&& entries, alias_table&& picker)
+  : entries_{std::move(entries)}
+  , picker_ {std::move(picker)}
+  , id_ {id}
+{
+    BK_ASSERT(picker_.size() == entries_.size());
+}
+
+loot_table::item_list loot_table::roll(random_t& random) const {
     std::vector<item_ref>  items;
     boost::container::flat_set<loot_table_ref> history;
 
@@ -41,9 +46,9 @@ loot_table::item_list loot_table::roll(random_t& random) {
     return items;
 }
 
-void loot_table::roll(random_t& random, item_list& items, history_t& history) {
-    auto const i = distribution_(random);
-    BK_ASSERT(i >= 0 && i < entries_.size());
+void loot_table::roll(random_t& random, item_list& items, history_t& history) const {
+    auto const i = picker_(random);
+    BK_ASSERT(i < entries_.size());
 
     auto const& entry   = entries_[i];
     auto const  is_item = boost::apply_visitor(visitor(), entry.value);
@@ -58,24 +63,134 @@ void loot_table::roll(random_t& random, item_list& items, history_t& history) {
         return;
     }
 
-    auto const value = *boost::get<loot_table_ref>(&entry.value);
-    auto const table = tez::loot_table_table::get(value);
+    //unlinked; reported by link_loot_tables
+    auto const table = entry.table;
     if (table == nullptr) {
-        BK_DEBUG_BREAK();
+        return;
     }
 
-    //auto const where = history.lower_bound(reference());
-    //if (where != std::cend(history) && *where == reference()) {
-    //    BK_DEBUG_BREAK();
-    //}
-
-    //history.emplace_hint(where, reference());
-
     for (auto j = 0; j < count; ++j) {
         table->roll(random, items, history);
     }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// tez::link_loot_tables
+////////////////////////////////////////////////////////////////////////////////
+struct tez::loot_linker {
+    using container_t = tez::loot_table_table::container_t;
+
+    enum class state : uint8_t {
+        unvisited, visiting, done
+    };
+
+    explicit loot_linker(container_t& tables)
+      : tables_ (tables)
+      , states_ (tables.size(), state::unvisited)
+    {
+    }
+
+    loot_link_errors operator()() {
+        for (size_t i = 0; i < tables_.size(); ++i) {
+            visit_(i);
+        }
+
+        return std::move(errors_);
+    }
+private:
+    void error_(loot_link_error::kind const type, loot_table const& table, hash_t const target) {
+        errors_.push_back(loot_link_error {type, table.reference(), target});
+    }
+
+    //depth first; an entry leading back to a table still being visited
+    //closes a cycle.
+    void visit_(size_t const i) {
+        if (states_[i] != state::unvisited) {
+            return;
+        }
+
+        states_[i] = state::visiting;
+
+        auto& table = (tables_.begin() + i)->second;
+
+        for (auto& entry : table.entries_) {
+            entry.table = nullptr;
+
+            if (auto const item = boost::get<item_ref>(&entry.value)) {
+                if (tez::item_table::is_loaded() && !tez::item_table::get(*item)) {
+                    error_(loot_link_error::kind::dangling_item, table, item->value);
+                }
+
+                continue;
+            }
+
+            auto const ref   = *boost::get<loot_table_ref>(&entry.value);
+            auto const where = tables_.find(ref);
+
+            if (where == tables_.end()) {
+                error_(loot_link_error::kind::dangling_table, table, ref.value);
+                continue;
+            }
+
+            auto const j = static_cast<size_t>(where - tables_.begin());
+
+            visit_(j);
+
+            if (states_[j] == state::visiting) {
+                error_(loot_link_error::kind::cycle, table, ref.value);
+                continue;
+            }
+
+            entry.table = &where->second;
+        }
+
+        states_[i] = state::done;
+    }
+
+    container_t&       tables_;
+    std::vector<state> states_;
+    loot_link_errors   errors_;
+};
+
+loot_link_errors tez::link_loot_tables(loot_table_table::container_t& tables) {
+    return loot_linker {tables}();
+}
+
+bool tez::relink_loot_tables() {
+    auto const current = loot_table_table::snapshot();
+    if (!current) {
+        return false;
+    }
+
+    //publish links the copy; its entries still point into current until then
+    loot_table_table::publish(loot_table_table::container_t {*current});
+
+    return true;
+}
+
+void tez::detail::link_table(tag_loot_table*, loot_table_table::container_t& tables) {
+    auto const errors = link_loot_tables(tables);
+
+    for (auto const& error : errors) {
+        auto const table  = tables.find(error.table);
+        auto const target = tables.find(loot_table_ref {error.target});
+
+        std::cout << "loot table \"" << table->second.id() << "\": ";
+
+        switch (error.type) {
+        case loot_link_error::kind::dangling_table : std::cout << "unknown table "; break;
+        case loot_link_error::kind::dangling_item :  std::cout << "unknown item ";  break;
+        case loot_link_error::kind::cycle :          std::cout << "cycle through "; break;
+        }
+
+        if (error.type == loot_link_error::kind::cycle && target != tables.end()) {
+            std::cout << "\"" << target->second.id() << "\"" << std::endl;
+        } else {
+            std::cout << std::hex << error.target << std::dec << std::endl;
+        }
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // tez::loot_table_parser
 ////////////////////////////////////////////////////////////////////////////////
@@ -91,25 +206,37 @@ auto const KEY_ENTRY_TYPE_TABLE = make_string_ref("table");
 auto const KEY_DIST_UNIFORM     = make_string_ref("uniform");
 auto const KEY_DIST_NORMAL      = make_string_ref("normal");
 auto const KEY_DIST_FIXED       = make_string_ref("fixed");
-
-size_t const SIZE_ROOT         = 1;
-size_t const SIZE_TABLE        = 2;
-size_t const SIZE_ENTRY_MIN    = 3;
-size_t const SIZE_ENTRY_MAX    = 4;
-size_t const SIZE_DIST_UNIFORM = 3;
-size_t const SIZE_DIST_NORMAL  = 3;
-size_t const SIZE_DIST_FIXED   = 2;
-
-size_t const INDEX_DIST_TYPE          = 0;
-size_t const INDEX_DIST_UNIFORM_MIN   = 1;
-size_t const INDEX_DIST_UNIFORM_MAX   = 2;
-size_t const INDEX_DIST_NORMAL_MEAN   = 1;
-size_t const INDEX_DIST_NORMAL_STDDEV = 2;
-size_t const INDEX_DIST_FIXED_VALUE   = 1;
-size_t const INDEX_ENTRY_WEIGHT       = 0;
-size_t const INDEX_ENTRY_TYPE         = 1;
-size_t const INDEX_ENTRY_ID           = 2;
-size_t const INDEX_ENTRY_DIST         = 3;
+auto const KEY_DIST_BINOMIAL    = make_string_ref("binomial");
+auto const KEY_DIST_POISSON     = make_string_ref("poisson");
+
+size_t const SIZE_ROOT          = 1;
+size_t const SIZE_TABLE         = 2;
+size_t const SIZE_ENTRY_MIN     = 3;
+size_t const SIZE_ENTRY_MAX     = 4;
+size_t const SIZE_DIST_UNIFORM  = 3;
+size_t const SIZE_DIST_NORMAL   = 3;
+size_t const SIZE_DIST_FIXED    = 2;
+size_t const SIZE_DIST_BINOMIAL = 3;
+size_t const SIZE_DIST_POISSON  = 2;
+
+size_t const INDEX_DIST_TYPE             = 0;
+size_t const INDEX_DIST_UNIFORM_MIN      = 1;
+size_t const INDEX_DIST_UNIFORM_MAX      = 2;
+size_t const INDEX_DIST_NORMAL_MEAN      = 1;
+size_t const INDEX_DIST_NORMAL_STDDEV    = 2;
+size_t const INDEX_DIST_FIXED_VALUE      = 1;
+size_t const INDEX_DIST_BINOMIAL_TRIALS  = 1;
+size_t const INDEX_DIST_BINOMIAL_PERCENT = 2;
+size_t const INDEX_DIST_POISSON_MEAN     = 1;
+size_t const INDEX_ENTRY_WEIGHT          = 0;
+size_t const INDEX_ENTRY_TYPE            = 1;
+size_t const INDEX_ENTRY_ID              = 2;
+size_t const INDEX_ENTRY_DIST            = 3;
+
+//! reject the whole load: table @p id is well formed, but @p what.
+void reject(utf8string const& id, utf8string const& what) {
+    throw tez::data_error {"loot table \"" + id + "\": " + what};
+}
 
 }
 
@@ -173,6 +300,13 @@ void loot_table_parser::rule_table_def(cref json_value) {
             entries.emplace_back(std::move(entry_value_), std::move(entry_dist_));
         });
 
+        auto const has_weight = std::any_of(std::begin(weights), std::end(weights)
+          , [](double const w) { return w > 0.0; });
+
+        if (!has_weight) {
+            reject(table_id_, "no entry with a weight above 0");
+        }
+
         auto const ref = loot_table_ref{bklib::utf8string_hash(table_id_)};
         tables_.emplace(ref, loot_table{std::move(table_id_), std::move(entries), weights});
     } catch (json::error::base& e) {
@@ -200,7 +334,7 @@ void loot_table_parser::rule_table_entry(cref json_value) {
         } else if (entry_type_ == KEY_ENTRY_TYPE_TABLE) {
             entry_value_ = loot_table_ref{bklib::utf8string_hash(entry_id_)};
         } else {
-            BK_DEBUG_BREAK(); //TODO
+            reject(table_id_, "unknown entry type " + entry_type_);
         }
     } catch (json::error::base& e) {
         BK_JSON_ADD_TRACE(e);
@@ -210,6 +344,9 @@ void loot_table_parser::rule_table_entry(cref json_value) {
 void loot_table_parser::rule_entry_weight(cref json_value) {
     try {
         entry_weight_ = json::require_int(json_value);
+        if (entry_weight_ < 0) {
+            reject(table_id_, "negative weight " + std::to_string(entry_weight_));
+        }
     } catch (json::error::base& e) {
         BK_JSON_ADD_TRACE(e);
     }
@@ -245,8 +382,10 @@ void loot_table_parser::rule_entry_dist(cref json_value) {
         if (!rule_dist_uniform(type, json_value)
          && !rule_dist_normal(type, json_value)
          && !rule_dist_fixed(type, json_value)
+         && !rule_dist_binomial(type, json_value)
+         && !rule_dist_poisson(type, json_value)
         ) {
-            BK_DEBUG_BREAK(); //TODO
+            reject(table_id_, "unknown distribution " + type);
         }
     } catch (json::error::base& e) {
         BK_JSON_ADD_TRACE(e);
@@ -267,7 +406,11 @@ bool loot_table_parser::rule_dist_uniform(utf8string const& id, cref json_value)
         rule_dist_min(dist_min);
         rule_dist_max(dist_max);
 
-        entry_dist_ = distribution::make_normal(dist_min_, dist_max_);
+        if (dist_min_ > dist_max_) {
+            reject(table_id_, "uniform min above max");
+        }
+
+        entry_dist_ = distribution::make_uniform_int(dist_min_, dist_max_);
     } catch (json::error::base& e) {
         BK_JSON_ADD_TRACE(e);
     }
@@ -289,6 +432,10 @@ bool loot_table_parser::rule_dist_normal(utf8string const& id, cref json_value)
         rule_dist_mean(dist_mean);
         rule_dist_stddev(dist_stddev);
 
+        if (dist_stddev_ < 0) {
+            reject(table_id_, "negative stddev " + std::to_string(dist_stddev_));
+        }
+
         entry_dist_ = distribution::make_normal(dist_mean_, dist_stddev_);
     } catch (json::error::base& e) {
         BK_JSON_ADD_TRACE(e);
@@ -317,6 +464,52 @@ bool loot_table_parser::rule_dist_fixed(utf8string const& id, cref json_value) {
     return true;
 }
 
+bool loot_table_parser::rule_dist_binomial(utf8string const& id, cref json_value) {
+    try {
+        if (id != KEY_DIST_BINOMIAL) {
+            return false;
+        }
+
+        json::require_size(json_value, SIZE_DIST_BINOMIAL);
+
+        auto dist_trials  = json::require_key(json_value, INDEX_DIST_BINOMIAL_TRIALS);
+        auto dist_percent = json::require_key(json_value, INDEX_DIST_BINOMIAL_PERCENT);
+
+        rule_dist_trials(dist_trials);
+        rule_dist_percent(dist_percent);
+
+        entry_dist_ = distribution::make_binomial(dist_trials_, dist_percent_ / 100.0);
+    } catch (json::error::base& e) {
+        BK_JSON_ADD_TRACE(e);
+    }
+
+    return true;
+}
+
+bool loot_table_parser::rule_dist_poisson(utf8string const& id, cref json_value) {
+    try {
+        if (id != KEY_DIST_POISSON) {
+            return false;
+        }
+
+        json::require_size(json_value, SIZE_DIST_POISSON);
+
+        auto dist_mean = json::require_key(json_value, INDEX_DIST_POISSON_MEAN);
+
+        rule_dist_mean(dist_mean);
+
+        if (dist_mean_ < 0) {
+            reject(table_id_, "negative mean " + std::to_string(dist_mean_));
+        }
+
+        entry_dist_ = distribution::make_poisson(dist_mean_);
+    } catch (json::error::base& e) {
+        BK_JSON_ADD_TRACE(e);
+    }
+
+    return true;
+}
+
 void loot_table_parser::rule_dist_min(cref json_value) {
     try {
         dist_min_ = json::require_int(json_value);
@@ -357,9 +550,30 @@ void loot_table_parser::rule_dist_value(cref json_value) {
     }
 }
 
+void loot_table_parser::rule_dist_trials(cref json_value) {
+    try {
+        dist_trials_ = json::require_int(json_value);
+        if (dist_trials_ < 0) {
+            reject(table_id_, "negative trials " + std::to_string(dist_trials_));
+        }
+    } catch (json::error::base& e) {
+        BK_JSON_ADD_TRACE(e);
+    }
+}
+
+void loot_table_parser::rule_dist_percent(cref json_value) {
+    try {
+        dist_percent_ = json::require_int(json_value);
+        if (dist_percent_ < 0 || dist_percent_ > 100) {
+            reject(table_id_, "percent outside [0, 100] " + std::to_string(dist_percent_));
+        }
+    } catch (json::error::base& e) {
+        BK_JSON_ADD_TRACE(e);
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // loot_table_table
 ////////////////////////////////////////////////////////////////////////////////
 
-bool                               tez::loot_table_table::is_loaded_ {false};
-tez::loot_table_table::container_t tez::loot_table_table::data_      {};
+tez::loot_table_table::state_t tez::loot_table_table::state_ {};
@@ -0,0 +1,73 @@
+#include "prefab.hpp"
+
+#include <bklib/assert.hpp>
+
+using tez::prefab;
+using tez::orientation;
+
+////////////////////////////////////////////////////////////////////////////////
+// tez::prefab
+////////////////////////////////////////////////////////////////////////////////
+namespace {
+
+using grid_t = prefab::grid_t;
+
+//------------------------------------------------------------------------------
+//! @p source mirrored left to right if @p mirror, then rotated clockwise by
+//! 90 degrees @p turns times.
+//------------------------------------------------------------------------------
+grid_t transform(grid_t const& source, bool const mirror, unsigned const turns) {
+    auto const w = source.width();
+    auto const h = source.height();
+
+    auto const odd = (turns % 2) != 0;
+
+    grid_t result {odd ? h : w, odd ? w : h};
+
+    for (size_t y = 0; y < h; ++y) {
+        auto const src = source.row(y);
+
+        for (size_t x = 0; x < w; ++x) {
+            auto xx = mirror ? w - 1 - x : x;
+            auto yy = y;
+
+            //rotate clockwise inside a (ww x hh) rect
+            auto ww = w;
+            auto hh = h;
+
+            for (unsigned i = 0; i < turns; ++i) {
+                auto const tmp = xx;
+                xx = hh - 1 - yy;
+                yy = tmp;
+                std::swap(ww, hh);
+            }
+
+            result.row(yy)[xx] = src[x];
+        }
+    }
+
+    return result;
+}
+
+} //namespace
+
+prefab::prefab(grid_t const& source) {
+    for (size_t i = 0; i < variants_.size(); ++i) {
+        auto const mirror = i >= static_cast<size_t>(orientation::mirror_r0);
+        auto const turns  = static_cast<unsigned>(i % 4);
+
+        variants_[i] = transform(source, mirror, turns);
+    }
+}
+
+prefab::prefab(prefab&& other) {
+    *this = std::move(other);
+}
+
+prefab& prefab::operator=(prefab&& rhs) {
+    for (size_t i = 0; i < variants_.size(); ++i) {
+        variants_[i].swap(rhs.variants_[i]);
+    }
+
+    return *this;
+}
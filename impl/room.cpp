@@ -1,4 +1,5 @@
 #include "room.hpp"
+#include "prefab.hpp"
 #include <bklib/macros.hpp>
 
 //==============================================================================
@@ -19,17 +20,37 @@ room::room(
 using room_simple = tez::generator::room_simple;
 
 room room_simple::generate(random& rand) {
-    auto const w = width_(rand);
-    auto const h = height_(rand);
+    auto const w = static_cast<unsigned>(width_(rand));
+    auto const h = static_cast<unsigned>(height_(rand));
 
-    return room_simple_fixed{w, h}.generate(rand);
+    auto const key   = std::make_pair(w, h);
+    auto       where = fixed_.lower_bound(key);
+    if (where == std::end(fixed_) || where->first != key) {
+        where = fixed_.emplace_hint(where, key, room_simple_fixed {w, h});
+    }
+
+    return where->second.generate(rand);
 }
 //==============================================================================
 using room_simple_fixed = tez::generator::room_simple_fixed;
 
+room_simple_fixed::room_simple_fixed(unsigned const w, unsigned const h)
+  : width_  {w}
+  , height_ {h}
+  , prefab_ {std::make_shared<tez::prefab const>(build())}
+{
+}
+
 room room_simple_fixed::generate(random& rand) const {
     BK_UNUSED(rand);
 
+    auto result = room {width_, height_};
+    prefab_->stamp(result, 0, 0);
+
+    return result;
+}
+
+room room_simple_fixed::build() const {
     auto const value = tez::tile_data{tez::tile_type::floor};
 
     auto result = room {width_, height_, value};
@@ -2,6 +2,7 @@
 
 #include <boost/container/flat_set.hpp>
 
+#include <bklib/assert.hpp>
 #include <bklib/json_forward.hpp>
 
 #include "util.hpp"
@@ -57,6 +58,11 @@ public:
     }
 
     item_attribute_ref name() const BK_NOEXCEPT { return name_; }
+    type               kind() const BK_NOEXCEPT { return type_; }
+
+    int32_t    int_value()    const { BK_ASSERT(type_ == type::integer);        return int_val_; }
+    float      float_value()  const { BK_ASSERT(type_ == type::floating_point); return float_val_; }
+    string_ref string_value() const { BK_ASSERT(type_ == type::string);         return {str_val_}; }
 private:
     union {
         char    str_val_[32];
@@ -148,7 +154,7 @@ public:
 namespace detail {
     template <> struct tag_traits<tag_item> {
         using type    = item_definition;
-        using pointer = item_definition*;
+        using pointer = item_definition const*;
         using ref     = item_ref;
         using parser  = item_parser;
     };
@@ -84,6 +84,13 @@ public:
     using value_t     = utf8string;
     using container_t = boost::container::flat_map<key_t, value_t>;
 
+    language_string_map() = default;
+
+    explicit language_string_map(container_t&& strings)
+      : strings_ {std::move(strings)}
+    {
+    }
+
     template <typename LangIter, typename StringIter>
     void insert(LangIter first_l, LangIter last_l, StringIter first_s, StringIter last_s) {
         strings_.reserve(last_l  - first_l);
@@ -112,6 +119,8 @@ public:
 
         return {where->second};
     }
+
+    container_t const& strings() const BK_NOEXCEPT { return strings_; }
 private:
     container_t strings_;
 };
@@ -0,0 +1,1651 @@
+#pragma once
+
+#include <bklib/config.hpp>
+#include <bklib/assert.hpp>
+#include <bklib/math.hpp>
+
+#include "algorithms.hpp"
+#include "alloc_stats.hpp"
+#include "arena.hpp"
+#include "random.hpp"
+#include "parallel.hpp"
+#include "types.hpp"
+
+//! Bump whenever the generated output for a given seed and params changes.
+unsigned const LEVEL_GENERATOR_VERSION = 3;
+
+template <typename Container, typename Function>
+inline void for_each_i(Container& container, Function function) {
+    using value_t = typename Container::value_type;
+
+    size_t i = 0;
+
+    std::for_each(std::begin(container), std::end(container), [&](value_t& value) {
+        function(value, i++);
+    });
+}
+
+template <typename Test, typename Fail>
+using if_void_t = typename std::conditional<
+    std::is_void<Test>::value
+  , Fail
+  , Test
+>::type;
+
+template <typename T>
+inline T clamp(T value, T min, T max) {
+    return (value < min)
+      ? min
+      : (value > max)
+        ? max
+        : value
+    ;
+}
+
+template <typename Test, typename Result = void>
+using enable_if_integral_t = typename std::enable_if<
+    std::is_integral<Test>::value
+  , Result
+>::type;
+
+template <typename Test, typename Result = void>
+using enable_if_float_t = typename std::enable_if<
+    std::is_floating_point<Test>::value
+  , Result
+>::type;
+
+
+template <typename T, enable_if_integral_t<T>* = nullptr>
+inline T ceil_div(T const dividend, T const divisor) {
+    return (dividend / divisor) + ((dividend % divisor) ? 1 : 0);
+}
+
+template <typename T, enable_if_float_t<T>* = nullptr>
+inline T ceil_div(T const dividend, T const divisor) {
+    return std::ceil(dividend / divisor);
+}
+
+class room_rect_set {
+public:
+    ////////////////////////////////////////////////////////////////////////////
+    // types
+    ////////////////////////////////////////////////////////////////////////////
+    using rect_t  = bklib::axis_aligned_rect<int>;
+    using point_t = bklib::point2d<int>;
+
+    struct value_t {
+        value_t(rect_t base) : base {base} {}
+
+        rect_t base     = rect_t {};
+        rect_t hole     = rect_t {};
+        bool   has_hole = false;
+    };
+
+    using allocator_t    = tez::arena_allocator<value_t>;
+    using container_t    = std::vector<value_t, allocator_t>;
+    using iterator       = container_t::iterator;
+    using const_iterator = container_t::const_iterator;
+    ////////////////////////////////////////////////////////////////////////////
+    // traversal
+    ////////////////////////////////////////////////////////////////////////////
+    const_iterator begin() const { return rects_.begin(); }
+    const_iterator end()   const { return rects_.end(); }
+
+    iterator begin() { return rects_.begin(); }
+    iterator end()   { return rects_.end(); }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // properties
+    ////////////////////////////////////////////////////////////////////////////
+    bool   empty() const BK_NOEXCEPT { return rects_.empty(); }
+    size_t size()  const BK_NOEXCEPT { return rects_.size(); }
+
+    int px(int dx, int dy) const BK_NOEXCEPT {
+        BK_ASSERT(!empty());
+        auto const r = rects_.begin()->base;
+
+        if (dx < 0)      return r.left();
+        else if (dx > 0) return r.right() - 1;
+        else             return r.left() + r.width() / 2; //TODO
+    }
+
+    int py(int dx, int dy) const BK_NOEXCEPT {
+        BK_ASSERT(!empty());
+        auto const r = rects_.begin()->base;
+
+        if (dy < 0)      return r.top();
+        else if (dy > 0) return r.bottom() - 1;
+        else             return r.top() + r.height() / 2; //TODO
+
+    }
+    ////////////////////////////////////////////////////////////////////////////
+    // lifetime
+    ////////////////////////////////////////////////////////////////////////////
+    explicit room_rect_set(rect_t rect, allocator_t const& alloc = allocator_t {})
+      : rects_(alloc)
+    {
+        add(rect);
+    }
+
+    //! copy @p other into storage from @p alloc.
+    room_rect_set(room_rect_set const& other, allocator_t const& alloc)
+      : rects_(other.rects_.begin(), other.rects_.end(), alloc)
+    {
+    }
+    ////////////////////////////////////////////////////////////////////////////
+    // operations
+    ////////////////////////////////////////////////////////////////////////////
+
+    //--------------------------------------------------------------------------
+    //! Geometrically add a rectangle to the set.
+    //--------------------------------------------------------------------------
+    void add(rect_t rect) {
+        rects_.emplace_back(rect);
+    }
+
+    //--------------------------------------------------------------------------
+    //! Geometrically subtract a rectangle to the set.
+    //! @param where
+    //!     An iterator to the existing rectangle to add a "hole" to.
+    //! @param hole
+    //!     The rectangle to subtract.
+    //! @pre @p where must be dereferenceable.
+    //! @pre @p hole must be strictly smaller than the rectangle at @p where.
+    //! @pre @p hole must strictly intersect the rectangle at @p where.
+    //--------------------------------------------------------------------------
+    void subtract(iterator where, rect_t hole) {
+        //must be a valid position
+        BK_ASSERT(where != end());
+        auto& value = *where;
+
+        //hole must be strictly smaller in width and height
+        BK_ASSERT(hole.width()  < value.base.width());
+        BK_ASSERT(hole.height() < value.base.height());
+
+        //hole must be entirely contained within base
+        BK_ASSERT(bklib::intersection_of(value.base, hole).result == hole);
+
+        value.has_hole = true;
+        value.hole     = hole;
+    }
+
+    //--------------------------------------------------------------------------
+    //! Intersection tests.
+    //--------------------------------------------------------------------------
+    bool intersects(rect_t const& r) const {
+        using namespace std::placeholders;
+        return std::any_of(begin(), end(), std::bind(intersects_<rect_t>, _1, std::cref(r)));
+    }
+    //--------------------------------------------------------------------------
+    bool intersects(point_t const& p) const {
+        using namespace std::placeholders;
+        return std::any_of(begin(), end(), std::bind(intersects_<point_t>, _1, std::cref(p)));
+    }
+    //--------------------------------------------------------------------------
+    bool intersects(room_rect_set const& other) const {
+        auto const end1 = end();
+        auto const end2 = other.end();
+
+        for (auto it1 = begin(); it1 != end1; ++it1) {
+            for (auto it2 = other.begin(); it2 != end2; ++it2) {
+                if (intersects_(*it1, *it2)) {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    //--------------------------------------------------------------------------
+    //! Translate by the vector (@p dx, @p dy).
+    //--------------------------------------------------------------------------
+    void translate(int dx, int dy) {
+        for (auto& value : rects_) {
+            value.base.translate(dx, dy);
+            if (value.has_hole) {
+                value.hole.translate(dx, dy);
+            }
+        }
+    }
+public:
+    static room_rect_set merge(room_rect_set&& a, room_rect_set&& b) {
+        auto const size_a = a.rects_.capacity();
+        auto const size_b = b.rects_.capacity();
+
+        auto& out = size_a > size_b ? a : b;
+        auto& in  = size_a > size_b ? b : a;
+
+        std::move(in.begin(), in.end(), std::back_inserter(out.rects_));
+        in.rects_.clear();
+
+        room_rect_set result = std::move(out);
+
+        return result;
+    }
+private:
+    template <typename T>
+    static bool intersects_(value_t const& a, T const& b);
+
+    template <>
+    static inline bool intersects_<value_t>(value_t const& a, value_t const& b) {
+        return bklib::intersects(a.base, b.base);
+    }
+
+    template <>
+    static inline bool intersects_<rect_t>(value_t const& a, rect_t const& b) {
+        return bklib::intersects(a.base, b)
+            && a.has_hole
+            && !bklib::intersects(a.hole, b)
+        ;
+    }
+
+    template <>
+    static inline bool intersects_<point_t>(value_t const& a, point_t const& b) {
+        return bklib::intersects(a.base, b)
+            && a.has_hole
+            && !bklib::intersects(a.hole, b)
+        ;
+    }
+
+    container_t rects_;
+};
+
+//==============================================================================
+//! Merge every group of intersecting sets in @p rooms into one set, and drop
+//! the emptied ones. Intersecting pairs are found with a sweep line and
+//! grouped transitively with a union-find, so a chain of overlaps (a with b,
+//! b with c) ends up in a single set even where its ends do not meet.
+//!
+//! Scratch space comes from the allocator of @p rooms.
+//==============================================================================
+inline void merge_intersecting(tez::arena_vector<room_rect_set>& rooms) {
+    using rect_t = room_rect_set::rect_t;
+
+    auto const n = rooms.size();
+    if (n < 2) {
+        return;
+    }
+
+    auto const alloc = rooms.get_allocator();
+
+    tez::arena_vector<rect_t> rects(alloc);
+    tez::arena_vector<size_t> owners(alloc);
+
+    for_each_i(rooms, [&](room_rect_set& u, size_t const i) {
+        for (auto const& value : u) {
+            rects.push_back(value.base);
+            owners.push_back(i);
+        }
+    });
+
+    bklib::basic_disjoint_set<tez::arena_allocator<size_t>> sets {n, alloc};
+
+    bklib::for_each_intersecting_pair(rects, [&](size_t const a, size_t const b) {
+        sets.unite(owners[a], owners[b]);
+    });
+
+    //move every union into its representative
+    for (size_t i = 0; i < n; ++i) {
+        auto const root = sets.find(i);
+        if (root != i) {
+            rooms[root] = room_rect_set::merge(std::move(rooms[root]), std::move(rooms[i]));
+        }
+    }
+
+    auto const is_empty = [](room_rect_set const& u) {
+        return u.empty();
+    };
+
+    rooms.erase(
+        std::remove_if(std::begin(rooms), std::end(rooms), is_empty)
+        , std::end(rooms)
+    );
+}
+
+//==============================================================================
+//! A rectilinear polygon (with any number of holes) stored as scanlines: for
+//! each row, the sorted, disjoint, half open x intervals [x0, x1) inside it.
+//!
+//! Point containment is a binary search over the spans of one row, the area
+//! is exact, and rasterizing is one contiguous fill per span.
+//==============================================================================
+class room_polygon {
+public:
+    using rect_t      = room_rect_set::rect_t;
+    using point_t     = room_rect_set::point_t;
+    using allocator_t = tez::arena_allocator<int>;
+
+    struct span_t {
+        int x0;
+        int x1;
+    };
+
+    explicit room_polygon(allocator_t const& alloc = allocator_t {})
+      : rows_(alloc)
+      , spans_(alloc)
+    {
+    }
+
+    //--------------------------------------------------------------------------
+    //! The union of the base rects of @p rects minus the union of their holes.
+    //--------------------------------------------------------------------------
+    explicit room_polygon(room_rect_set const& rects, allocator_t const& alloc = allocator_t {})
+      : room_polygon {alloc}
+    {
+        if (rects.empty()) {
+            return;
+        }
+
+        bounds_ = rects.begin()->base;
+        for (auto const& value : rects) {
+            bounds_ = rect_t {
+                std::min(bounds_.left(),   value.base.left())
+              , std::min(bounds_.top(),    value.base.top())
+              , std::max(bounds_.right(),  value.base.right())
+              , std::max(bounds_.bottom(), value.base.bottom())
+            };
+        }
+
+        tez::arena_vector<span_t> solid(alloc);
+        tez::arena_vector<span_t> holes(alloc);
+
+        rows_.reserve(bounds_.height() + 1);
+
+        for (auto y = bounds_.top(); y < bounds_.bottom(); ++y) {
+            rows_.push_back(static_cast<uint32_t>(spans_.size()));
+
+            solid.clear();
+            holes.clear();
+
+            for (auto const& value : rects) {
+                add_if_covers_(solid, value.base, y);
+                if (value.has_hole) {
+                    add_if_covers_(holes, value.hole, y);
+                }
+            }
+
+            merge_(solid);
+            merge_(holes);
+            subtract_(solid, holes);
+        }
+
+        rows_.push_back(static_cast<uint32_t>(spans_.size()));
+    }
+
+    //--------------------------------------------------------------------------
+    //! O(log n) in the number of spans on row @p y.
+    //--------------------------------------------------------------------------
+    bool contains(int const x, int const y) const {
+        auto const r = row(y);
+
+        auto const where = std::upper_bound(r.first, r.second, x
+          , [](int const value, span_t const& span) { return value < span.x0; });
+
+        return where != r.first && x < (where - 1)->x1;
+    }
+
+    bool contains(point_t const p) const {
+        return contains(p.x, p.y);
+    }
+
+    //! the number of tiles inside.
+    size_t area() const BK_NOEXCEPT { return area_; }
+
+    bool empty() const BK_NOEXCEPT { return area_ == 0; }
+
+    rect_t bounds() const BK_NOEXCEPT { return bounds_; }
+
+    //--------------------------------------------------------------------------
+    //! The spans on row @p y as [first, last); empty outside the bounds.
+    //--------------------------------------------------------------------------
+    std::pair<span_t const*, span_t const*> row(int const y) const {
+        if (y < bounds_.top() || y >= bounds_.bottom()) {
+            return {nullptr, nullptr};
+        }
+
+        auto const i     = static_cast<size_t>(y - bounds_.top());
+        auto const first = spans_.data();
+
+        return {first + rows_[i], first + rows_[i + 1]};
+    }
+
+    //--------------------------------------------------------------------------
+    //! Call @c function(y, x0, x1) for every span, top to bottom, left to right.
+    //--------------------------------------------------------------------------
+    template <typename Function>
+    void for_each_span(Function function) const {
+        for (auto y = bounds_.top(); y < bounds_.bottom(); ++y) {
+            auto const r = row(y);
+            for (auto it = r.first; it != r.second; ++it) {
+                function(y, it->x0, it->x1);
+            }
+        }
+    }
+private:
+    using spans_t = tez::arena_vector<span_t>;
+
+    static void add_if_covers_(spans_t& out, rect_t const& r, int const y) {
+        if (y >= r.top() && y < r.bottom()) {
+            out.push_back(span_t {r.left(), r.right()});
+        }
+    }
+
+    //! sort and merge overlapping or touching spans.
+    static void merge_(spans_t& spans) {
+        if (spans.size() < 2) {
+            return;
+        }
+
+        std::sort(std::begin(spans), std::end(spans)
+          , [](span_t const& a, span_t const& b) { return a.x0 < b.x0; });
+
+        size_t n = 0;
+        for (size_t i = 1; i < spans.size(); ++i) {
+            if (spans[i].x0 <= spans[n].x1) {
+                spans[n].x1 = std::max(spans[n].x1, spans[i].x1);
+            } else {
+                spans[++n] = spans[i];
+            }
+        }
+
+        spans.resize(n + 1);
+    }
+
+    //! append @p solid minus @p holes to spans_; both sorted and disjoint.
+    void subtract_(spans_t const& solid, spans_t const& holes) {
+        auto h = std::begin(holes);
+
+        for (auto span : solid) {
+            while (h != std::end(holes) && h->x1 <= span.x0) {
+                ++h;
+            }
+
+            for (auto it = h; it != std::end(holes) && it->x0 < span.x1; ++it) {
+                if (it->x0 > span.x0) {
+                    push_(span.x0, it->x0);
+                }
+                span.x0 = std::max(span.x0, it->x1);
+            }
+
+            if (span.x0 < span.x1) {
+                push_(span.x0, span.x1);
+            }
+        }
+    }
+
+    void push_(int const x0, int const x1) {
+        spans_.push_back(span_t {x0, x1});
+        area_ += static_cast<size_t>(x1 - x0);
+    }
+
+    rect_t                      bounds_ = rect_t {};
+    tez::arena_vector<uint32_t> rows_;  //!< spans_[rows_[i], rows_[i+1]) is row top + i
+    spans_t                     spans_;
+    size_t                      area_   = 0;
+};
+
+//==============================================================================
+//! Parameters for grid_layout.
+//==============================================================================
+struct grid_layout_params {
+    //! grid cell size
+    int cell_size = 10;
+
+    //! min size for rectangles generated; must be >= 3.
+    int rect_min_size = 3;
+    //! max size for rectangles generated; must be < cell_size.
+    int rect_max_size = cell_size - 1;
+
+    //! mean size of generated rectangles.
+    float rect_size_mean   = 5.0f;
+    //! stddev for the size of generated rectangles.
+    float rect_size_stddev = 3.0f;
+
+    //! mean number of generated rectangles per "room".
+    float rects_per_cell_mean   = 1.0f;
+    //! stddev for the number of generated rectangles per "room".
+    float rects_per_cell_stddev = 1.0f;
+
+    //! probability that a given rect will have a "hole" in it.
+    float hole_probability = 0.25f;
+
+    //! width of the play field.
+    int field_w = 100;
+    //! height of the play field.
+    int field_h = 100;
+
+    int cells_w = field_w / cell_size;
+    int cells_h = field_h / cell_size;
+
+    //! number of threads used to generate cells; 0 for one per core.
+    //! the result does not depend on this.
+    unsigned thread_count = 0;
+
+    bool validate() {
+        static int const MIN_RECT_SIZE = 3;
+
+        if (cell_size < MIN_RECT_SIZE + 1) {
+            cell_size = MIN_RECT_SIZE + 1;
+        }
+
+        if (rect_min_size < MIN_RECT_SIZE) {
+            rect_min_size = MIN_RECT_SIZE;
+        }
+
+        if (rect_max_size > cell_size - 1) {
+            rect_max_size = cell_size - 1;
+        }
+
+        if (rect_max_size > cell_size - 1) {
+            rect_min_size = cell_size - 1;
+        }
+    }
+};
+
+//==============================================================================
+//! Where basic_grid_layout gets its parameters from.
+//!
+//! A policy is constructed from a grid_layout_params and exposes each
+//! parameter (everything but field_w, field_h and thread_count) as a member
+//! function of the same name. The presets return constants, so with them the
+//! distributions and cell arithmetic are compiled for fixed values; runtime
+//! reads the params and works for anything.
+//==============================================================================
+namespace layout_policy {
+
+//------------------------------------------------------------------------------
+//! Every parameter read from a grid_layout_params; the fallback.
+//------------------------------------------------------------------------------
+class runtime {
+public:
+    explicit runtime(grid_layout_params const& params = grid_layout_params {})
+      : p_ (params)
+    {
+    }
+
+    int   cell_size()             const BK_NOEXCEPT { return p_.cell_size; }
+    int   cells_w()               const BK_NOEXCEPT { return p_.cells_w; }
+    int   cells_h()               const BK_NOEXCEPT { return p_.cells_h; }
+    int   rect_min_size()         const BK_NOEXCEPT { return p_.rect_min_size; }
+    int   rect_max_size()         const BK_NOEXCEPT { return p_.rect_max_size; }
+    float rect_size_mean()        const BK_NOEXCEPT { return p_.rect_size_mean; }
+    float rect_size_stddev()      const BK_NOEXCEPT { return p_.rect_size_stddev; }
+    float rects_per_cell_mean()   const BK_NOEXCEPT { return p_.rects_per_cell_mean; }
+    float rects_per_cell_stddev() const BK_NOEXCEPT { return p_.rects_per_cell_stddev; }
+    float hole_probability()      const BK_NOEXCEPT { return p_.hole_probability; }
+private:
+    grid_layout_params p_;
+};
+
+//------------------------------------------------------------------------------
+//! grid_layout_params {}: 10 x 10 cells of 10 x 10 tiles.
+//------------------------------------------------------------------------------
+struct standard {
+    explicit standard(grid_layout_params const& = grid_layout_params {}) {}
+
+    static BK_CONSTEXPR int   cell_size()             BK_NOEXCEPT { return 10; }
+    static BK_CONSTEXPR int   cells_w()               BK_NOEXCEPT { return 10; }
+    static BK_CONSTEXPR int   cells_h()               BK_NOEXCEPT { return 10; }
+    static BK_CONSTEXPR int   rect_min_size()         BK_NOEXCEPT { return 3; }
+    static BK_CONSTEXPR int   rect_max_size()         BK_NOEXCEPT { return 9; }
+    static BK_CONSTEXPR float rect_size_mean()        BK_NOEXCEPT { return 5.0f; }
+    static BK_CONSTEXPR float rect_size_stddev()      BK_NOEXCEPT { return 3.0f; }
+    static BK_CONSTEXPR float rects_per_cell_mean()   BK_NOEXCEPT { return 1.0f; }
+    static BK_CONSTEXPR float rects_per_cell_stddev() BK_NOEXCEPT { return 1.0f; }
+    static BK_CONSTEXPR float hole_probability()      BK_NOEXCEPT { return 0.25f; }
+};
+
+//------------------------------------------------------------------------------
+//! 10 x 10 cells of 20 x 20 tiles with larger, busier rooms.
+//------------------------------------------------------------------------------
+struct large {
+    explicit large(grid_layout_params const& = grid_layout_params {}) {}
+
+    static BK_CONSTEXPR int   cell_size()             BK_NOEXCEPT { return 20; }
+    static BK_CONSTEXPR int   cells_w()               BK_NOEXCEPT { return 10; }
+    static BK_CONSTEXPR int   cells_h()               BK_NOEXCEPT { return 10; }
+    static BK_CONSTEXPR int   rect_min_size()         BK_NOEXCEPT { return 3; }
+    static BK_CONSTEXPR int   rect_max_size()         BK_NOEXCEPT { return 19; }
+    static BK_CONSTEXPR float rect_size_mean()        BK_NOEXCEPT { return 8.0f; }
+    static BK_CONSTEXPR float rect_size_stddev()      BK_NOEXCEPT { return 3.0f; }
+    static BK_CONSTEXPR float rects_per_cell_mean()   BK_NOEXCEPT { return 3.0f; }
+    static BK_CONSTEXPR float rects_per_cell_stddev() BK_NOEXCEPT { return 1.0f; }
+    static BK_CONSTEXPR float hole_probability()      BK_NOEXCEPT { return 0.25f; }
+
+    //! the params this preset stands for.
+    static grid_layout_params params() {
+        grid_layout_params p;
+        p.cell_size           = cell_size();
+        p.rect_max_size       = rect_max_size();
+        p.rect_size_mean      = rect_size_mean();
+        p.rects_per_cell_mean = rects_per_cell_mean();
+        p.field_w             = cell_size() * cells_w();
+        p.field_h             = cell_size() * cells_h();
+        p.cells_w             = cells_w();
+        p.cells_h             = cells_h();
+        return p;
+    }
+};
+
+//------------------------------------------------------------------------------
+//! Whether @p Policy generates the same output as runtime for @p params.
+//------------------------------------------------------------------------------
+template <typename Policy>
+inline bool matches(grid_layout_params const& params) {
+    Policy const p {params};
+
+    return p.cell_size()             == params.cell_size
+        && p.cells_w()               == params.cells_w
+        && p.cells_h()               == params.cells_h
+        && p.rect_min_size()         == params.rect_min_size
+        && p.rect_max_size()         == params.rect_max_size
+        && p.rect_size_mean()        == params.rect_size_mean
+        && p.rect_size_stddev()      == params.rect_size_stddev
+        && p.rects_per_cell_mean()   == params.rects_per_cell_mean
+        && p.rects_per_cell_stddev() == params.rects_per_cell_stddev
+        && p.hole_probability()      == params.hole_probability;
+}
+
+} //namespace layout_policy
+
+//==============================================================================
+//! Generates room rects on a grid of cells; the parameters come from Policy
+//! (see layout_policy). Use grid_layout, which picks the policy.
+//==============================================================================
+template <typename Policy>
+class basic_grid_layout {
+public:
+    //--------------------------------------------------------------------------
+    using params_t     = grid_layout_params;
+    using policy_t     = Policy;
+    using rect         = bklib::axis_aligned_rect<int>;
+    using cell_t       = tez::arena_vector<room_rect_set>;
+    using random_t     = tez::random_t;
+    using dist_normal  = std::normal_distribution<float>;
+    using dist_uniform = std::uniform_int_distribution<int>;
+    //--------------------------------------------------------------------------
+
+    //--------------------------------------------------------------------------
+    // using params, generate a random layout where each cell draws from its own
+    // stream derived from (seed, cell index); cells are generated in parallel
+    // and the result is the same for any thread count.
+    //
+    // scratch space is taken from arena if given; the result is always on the
+    // heap.
+    //--------------------------------------------------------------------------
+    std::vector<room_rect_set> operator()(
+        params_t const params, uint64_t const seed, random_t& random
+      , tez::arena* const arena = nullptr
+    ) {
+        thread_count_ = params.thread_count;
+        policy_       = policy_t {params};
+
+        size_t const cell_count = policy_.cells_h() * policy_.cells_w();
+
+        //filling by copy would put every cell on the heap (see arena_allocator)
+        tez::arena_allocator<cell_t> const alloc {arena};
+        cells_ = cells_t(alloc);
+        cells_.reserve(cell_count);
+        for (size_t i = 0; i < cell_count; ++i) {
+            cells_.emplace_back(alloc);
+        }
+
+        //----------------------------------------------------------------------
+        // for each cell, generate a random number of rooms and merge.
+        //----------------------------------------------------------------------
+        tez::parallel_for(cell_count, thread_count_, [&](size_t const i) {
+            auto cell_random = tez::make_stream(seed, i);
+            generate_cell_(cells_[i], i, cell_random);
+        });
+
+        shift_cell_rects_(random);
+
+        //----------------------------------------------------------------------
+        // merge the contents of all the cells into one vector.
+        //----------------------------------------------------------------------
+        std::vector<room_rect_set> result;
+        result.reserve(cell_count);
+
+        for (auto& cell : cells_) {
+            for (auto& rect : cell) {
+                if (!rect.empty()) {
+                    result.emplace_back(rect, room_rect_set::allocator_t {});
+                }
+            }
+        }
+
+        //the scratch may not outlive arena
+        cells_ = cells_t {};
+
+        return result;
+    }
+private:
+    //--------------------------------------------------------------------------
+    policy_t policy_;
+    unsigned thread_count_ = 0;
+
+    using cells_t = tez::arena_vector<cell_t>;
+
+    cells_t cells_;
+    //--------------------------------------------------------------------------
+
+    int draw_size_(dist_normal& dist, random_t& random) const {
+        auto const value   = dist(random);
+        auto const rounded = static_cast<int>(std::round(value));
+        return clamp(rounded, policy_.rect_min_size(), policy_.rect_max_size());
+    }
+
+    static int draw_count_(dist_normal& dist, random_t& random) {
+        auto const value   = dist(random);
+        auto const rounded = static_cast<int>(std::round(value));
+        return rounded < 0 ? 0 : rounded;
+    }
+
+    //--------------------------------------------------------------------------
+    // generate a random number of rooms for the cell with index i and merge.
+    // safe to call concurrently for different cells.
+    //--------------------------------------------------------------------------
+    void generate_cell_(cell_t& cell, size_t const i, random_t& random) const {
+        //the distributions carry state; each cell gets fresh ones.
+        dist_normal size_dist  {policy_.rect_size_mean(),      policy_.rect_size_stddev()};
+        dist_normal count_dist {policy_.rects_per_cell_mean(), policy_.rects_per_cell_stddev()};
+
+        auto hole_gen = std::uniform_real_distribution<float>{};
+
+        auto const cell_rect = get_cell_rect_(i);
+
+        auto const count = draw_count_(count_dist, random);
+        for (auto n = 0; n < count; ++n) {
+            auto const room_rect = generate_rect_(cell_rect, size_dist, random);
+            cell.emplace_back(room_rect, cell.get_allocator());
+
+            if ( room_rect.width() >= 5 && room_rect.height() >= 5 &&
+                hole_gen(random) <= policy_.hole_probability()
+            ) {
+                auto const hole_rect = generate_hole_(room_rect, random);
+                auto& room = cell.back();
+                room.subtract(room.begin(), hole_rect);
+            }
+        }
+
+        merge_intersecting(cell);
+    }
+
+    rect generate_hole_(rect const& base_rect, random_t& random) const {
+        auto const width  = base_rect.width();
+        auto const height = base_rect.height();
+
+        auto const w_max = width  - 4;
+        auto const h_max = height - 4;
+
+        auto const w = dist_uniform{1, w_max}(random);
+        auto const h = dist_uniform{1, h_max}(random);
+
+        auto const x_max = width  - w - 4;
+        auto const y_max = height - h - 4;
+
+        auto const dx = x_max < 1 ? 0 : dist_uniform(0, x_max)(random);
+        auto const dy = y_max < 1 ? 0 : dist_uniform(0, y_max)(random);
+
+        auto const x0 = base_rect.left() + dx + 2;
+        auto const y0 = base_rect.top()  + dy + 2;
+        auto const x1 = x0 + w;
+        auto const y1 = y0 + h;
+
+        return rect {x0, y0, x1, y1};
+    }
+
+    //--------------------------------------------------------------------------
+    // generate a rectangle that fits inside cell_rect.
+    //--------------------------------------------------------------------------
+    rect generate_rect_(rect const& cell_rect, dist_normal& size_dist, random_t& random) const {
+        auto const w = draw_size_(size_dist, random);
+        auto const h = draw_size_(size_dist, random);
+
+        auto const dx = dist_uniform(0, policy_.cell_size() - w - 1)(random);
+        auto const dy = dist_uniform(0, policy_.cell_size() - h - 1)(random);
+
+        auto const x0 = cell_rect.left() + dx;
+        auto const y0 = cell_rect.top()  + dy;
+        auto const x1 = x0 + w;
+        auto const y1 = y0 + h;
+
+        return rect {x0, y0, x1, y1};
+    }
+
+    //--------------------------------------------------------------------------
+    // get the rectangle corresponding to the cell with index i.
+    //--------------------------------------------------------------------------
+    rect get_cell_rect_(size_t const i) const {
+        auto const sz = policy_.cell_size();
+        auto const w  = policy_.cells_w();
+
+        auto const div = std::div(i, w);
+
+        auto const xi = div.rem;
+        auto const yi = div.quot;
+
+        auto const x0 = xi * sz;
+        auto const y0 = yi * sz;
+        auto const x1 = x0 + sz;
+        auto const y1 = y0 + sz;
+
+        return {x0, y0, x1, y1};
+    }
+
+    //--------------------------------------------------------------------------
+    // once, for all empty cells, shift a neighboring cell's contents toward the
+    // the empty cell by a random amount.
+    //--------------------------------------------------------------------------
+    void shift_cell_rects_(random_t& random) {
+        boost::container::flat_set<
+            size_t, std::less<size_t>, tez::arena_allocator<size_t>
+        > used(cells_.get_allocator());
+
+        //for each cell
+        for_each_i(cells_, [&](cell_t& cell, size_t const cell_index) {
+            //only empty cells
+            if (!cell.empty()) {
+                return;
+            }
+
+            auto const here = static_cast<int>(cell_index);
+            auto const w    = policy_.cells_w();
+
+            //indicies of cardinal neighbors
+            int const neighbor_indicies[4] {
+                here % w != 0     ? here - 1 : -1 //mind the edges
+              , here % w != w - 1 ? here + 1 : -1 //mind the edges
+              , here - w
+              , here + w
+            };
+
+            //start from a random neighbor
+            size_t const start = dist_uniform{0, 3}(random);
+
+            //for each neighbor...
+            for (size_t i = 0; i < 4; ++i) {
+                auto const neighbor = (start + i) % 4;
+                auto const j = neighbor_indicies[neighbor];
+
+                if (j < 0 || j >= cells_.size()) {
+                    //bad index; try next
+                    continue;
+                } else if (used.find(j) != std::cend(used)) {
+                    //already used index; try next
+                    continue;
+                }
+
+                auto& target = cells_[j];
+
+                if (target.empty()) {
+                    //empty neighbor; try next
+                    continue;
+                }
+
+                //ok; mark neighbor as used
+                used.insert(j);
+
+                int const delta_min = 1;
+                int const delta_max = policy_.cell_size() - 1;
+                int const delta = dist_uniform {delta_min, delta_max}(random);
+
+                //for all rect unions...
+                for (auto& u : target) {
+                    switch (neighbor) {
+                    case 0 : u.translate( delta,  0);     break;
+                    case 1 : u.translate(-delta,  0);     break;
+                    case 2 : u.translate(0,       delta); break;
+                    case 3 : u.translate(0,      -delta); break;
+                    }
+                }
+
+                //done this cell
+                break;
+            }
+        });
+    }
+};
+
+//==============================================================================
+//! Generates room rects on a grid of cells. Params matching one of the
+//! layout_policy presets run with that preset's constants; anything else runs
+//! with layout_policy::runtime. The output is the same either way.
+//==============================================================================
+class grid_layout {
+public:
+    //--------------------------------------------------------------------------
+    using params_t = grid_layout_params;
+    using random_t = tez::random_t;
+    //--------------------------------------------------------------------------
+
+    //--------------------------------------------------------------------------
+    //
+    //--------------------------------------------------------------------------
+    std::vector<room_rect_set> operator()(random_t& random) {
+        return (*this)(params_t{}, random);
+    }
+
+    //--------------------------------------------------------------------------
+    // using params, generate a random layout.
+    //--------------------------------------------------------------------------
+    std::vector<room_rect_set> operator()(
+        params_t const params, random_t& random, tez::arena* const arena = nullptr
+    ) {
+        return (*this)(params, tez::make_seed(random), random, arena);
+    }
+
+    //--------------------------------------------------------------------------
+    // see basic_grid_layout.
+    //--------------------------------------------------------------------------
+    std::vector<room_rect_set> operator()(
+        params_t const params, uint64_t const seed, random_t& random
+      , tez::arena* const arena = nullptr
+    ) {
+        using namespace layout_policy;
+
+        if (matches<standard>(params)) {
+            return basic_grid_layout<standard>{}(params, seed, random, arena);
+        } else if (matches<large>(params)) {
+            return basic_grid_layout<large>{}(params, seed, random, arena);
+        }
+
+        return basic_grid_layout<runtime>{}(params, seed, random, arena);
+    }
+};
+
+struct tile_data {
+    enum class tile_type : uint16_t {
+        invalid, empty, corridor, floor, wall,
+    };
+
+    using room_id_t = uint16_t;
+    using tile_sub_type = uint16_t;
+
+    static room_id_t const ROOM_ID_NONE = 0;
+
+    tile_type     type     = tile_type::empty;
+    tile_sub_type sub_type = 0;
+    room_id_t     room_id  = ROOM_ID_NONE;
+};
+
+inline char as_char(tile_data::tile_type const t) {
+    using tile_type = tile_data::tile_type;
+
+    switch (t) {
+    case tile_type::invalid  : return '?';
+    case tile_type::empty    : return ' ';
+    case tile_type::corridor : return ',';
+    case tile_type::floor    : return '.';
+    case tile_type::wall     : return '#';
+    }
+
+    return '?';
+}
+
+struct tile_grid {
+    using element_t = tile_data;
+    using rect_t = bklib::axis_aligned_rect<int>;
+
+    tile_grid(size_t width, size_t height, element_t value = element_t{})
+      : width_{width}
+      , height_{height}
+    {
+        tiles_.resize(width*height, value);
+    }
+
+    element_t& at(size_t x, size_t y) {
+        BK_ASSERT(x < width_ && y < height_);
+        auto const i = y * width_ + x;
+        return tiles_[i];
+    }
+
+    element_t const& at(size_t x, size_t y) const {
+        return const_cast<tile_grid*>(this)->at(x, y);
+    }
+
+    void fill_rect(rect_t const rect, element_t value) {
+        BK_ASSERT(rect.left()  >= 0 && rect.top()    >= 0);
+        BK_ASSERT(rect.right() >= 0 && rect.bottom() >= 0);
+
+        for (auto y = rect.top(); y < rect.bottom(); ++y) {
+            for (auto x = rect.left(); x < rect.right(); ++x) {
+                at(x, y) = value;
+            }
+        }
+    }
+
+    //! fill [@p x0, @p x1) on row @p y with @p value.
+    void fill_span(int const y, int const x0, int const x1, element_t const value) {
+        BK_ASSERT(x0 <= x1);
+        BK_ASSERT(is_valid_index(x0, y) && (x0 == x1 || is_valid_index(x1 - 1, y)));
+
+        std::fill_n(tiles_.begin() + (y * width_ + x0), x1 - x0, value);
+    }
+
+    template <typename Function>
+    inline void for_each_xy(Function function) const {
+        for (size_t y = 0; y < height_; ++y) {
+            for (size_t x = 0; x < width_; ++x) {
+                function(x, y, at(x, y));
+            }
+        }
+    }
+
+    inline bool is_valid_index(int const x, int const y) const BK_NOEXCEPT {
+        return x >= 0
+            && static_cast<size_t>(x) < width_
+            && y >= 0
+            && static_cast<size_t>(y) < height_
+        ;
+    }
+
+    using block = std::array<
+        std::array<element_t*, 3>, 3
+    >;
+
+    block block_at(int const x, int const y) {
+        block b;
+
+        for (auto const yi : {-1, 0, 1}) {
+            for (auto const xi : {-1, 0, 1}) {
+                auto const xx = x + xi;
+                auto const yy = y + yi;
+
+                b[yi + 1][xi + 1] = is_valid_index(xx, yy) ? &at(xx, yy) : &at(x, y);
+            }
+        }
+
+        return b;
+    }
+
+
+    template <typename Function>
+    void for_each_neighbor(int const x, int const y, Function function) {
+        for (auto const yi : {-1, 0, 1}) {
+            for (auto const xi : {-1, 0, 1}) {
+                if ((xi | yi) == 0 || !is_valid_index(x + xi, y + yi)) continue;
+                function(xi, yi, at(x + xi, y + yi));
+            }
+        }
+    }
+
+    size_t width()  const BK_NOEXCEPT { return width_; }
+    size_t height() const BK_NOEXCEPT { return height_; }
+
+    size_t width_;
+    size_t height_;
+
+    std::vector<element_t> tiles_;
+};
+
+struct directed_walk {
+    using random_t      = tez::random_t;
+    using connections_t = boost::container::flat_set<
+        int, std::less<int>, tez::arena_allocator<int>
+    >;
+
+    bool rule(tile_grid::block const& b) const {
+        auto const is_floor = [](tile_data const* data) {
+            return data->type == tile_data::tile_type::floor ? 1 : 0;
+        };
+
+        auto const is_corridor = [](tile_data const* data) {
+            return data->type == tile_data::tile_type::corridor;
+        };
+
+        int const floor_n = is_floor(b[0][0]) + is_floor(b[0][1]) + is_floor(b[0][2]);
+        int const floor_s = is_floor(b[2][0]) + is_floor(b[2][1]) + is_floor(b[2][2]);
+        int const floor_e = is_floor(b[0][2]) + is_floor(b[1][2]) + is_floor(b[2][2]);
+        int const floor_w = is_floor(b[0][0]) + is_floor(b[1][0]) + is_floor(b[2][0]);
+
+        bool const corridor_ew = is_corridor(b[1][0]) || is_corridor(b[1][2]);
+        bool const corridor_ns = is_corridor(b[0][1]) || is_corridor(b[2][1]);
+
+        if (floor_n == 0 && floor_s == 0 && floor_e == 0 && floor_w == 0) {
+            return true;
+        } else if (!corridor_ew && floor_e != 3 && floor_e == floor_w) {
+            return (floor_n == 3 && floor_s == 0)
+                || (floor_n == 0 && floor_s == 3)
+                || (floor_n == 3 && floor_s == 3);
+        } else if (!corridor_ns && floor_n != 3 && floor_n == floor_s) {
+            return (floor_e == 3 && floor_w == 0)
+                || (floor_e == 0 && floor_w == 3)
+                || (floor_e == 3 && floor_w == 3);
+        } else {
+            return false;
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    //! @returns the ids of the rooms connected by the walk; the set is
+    //! allocated from @p arena if given.
+    //--------------------------------------------------------------------------
+    connections_t operator()(
+        random_t& random, tile_grid& grid
+      , int const start_room
+      , int const start_x,  int const start_y
+      , int const dir_x, int const dir_y
+      , tez::arena* const arena = nullptr
+    ) {
+        BK_ASSERT(std::abs(dir_x) <= 1);
+        BK_ASSERT(std::abs(dir_y) <= 1);
+
+        static float const forward  = 80;
+        static float const left     = 20;
+        static float const right    = 20;
+        static float const backward = 5;
+
+        static float const segment_length_mean   = 5.0f;
+        static float const segment_length_stddev = 3.0f;
+
+        std::discrete_distribution<> direction_gen {
+            forward, left, right, backward
+        };
+
+        std::normal_distribution<float> length_gen {segment_length_mean, segment_length_stddev};
+
+        auto x = start_x;
+        auto y = start_y;
+
+        BK_ASSERT(grid.is_valid_index(x, y));
+        BK_ASSERT(grid.at(x, y).type == tile_data::tile_type::floor);
+        BK_ASSERT(grid.at(x, y).room_id == start_room);
+
+        connections_t connections {tez::arena_allocator<int> {arena}};
+        connections.reserve(10);
+        connections.insert(start_room);
+
+        for (int iterations = 0; iterations < 10; ++iterations) {
+            auto const dir    = direction_gen(random);
+            auto const length = static_cast<int>(std::round(length_gen(random)));
+
+            auto dx = dir_x;
+            auto dy = dir_y;
+
+            switch (dir) {
+            case 0 : break;
+            case 1 : std::tie(dx, dy) = std::make_pair(dy,  dx); break;
+            case 2 : std::tie(dx, dy) = std::make_pair(-dy, -dx); break;
+            case 3 : std::tie(dx, dy) = std::make_pair(-dx, -dy); break;
+            }
+
+            for (int i = 0; i < length; ++i) {
+                if (!grid.is_valid_index(x, y)) {
+                    break; //try another direction TODO
+                }
+
+                auto&      data = grid.at(x, y);
+                auto const type = data.type;
+
+                if (type == tile_data::tile_type::empty) {
+                    auto const block = grid.block_at(x, y);
+
+                    if (rule(block)) {
+                        data.type = tile_data::tile_type::corridor;
+                        data.room_id = start_room;
+                    } else {
+                        break; //try another direction TODO
+                    }
+                } else if (type == tile_data::tile_type::corridor) {
+                    connections.insert(data.room_id);
+                } else if (type == tile_data::tile_type::floor) {
+                    if (data.room_id != start_room) {
+                        connections.insert(data.room_id);
+                        return connections;
+                    }
+                }
+
+                x += dx;
+                y += dy;
+            }
+        }
+
+        return connections;
+    }
+};
+
+//==============================================================================
+//! State shared by the stages of a level_pipeline; each stage reads what the
+//! stages before it produced and adds to it.
+//!
+//! Stages should take their scratch space from @c arena; it is released in
+//! one go when the context is destroyed.
+//==============================================================================
+struct level_context {
+    using random_t = tez::random_t;
+    using params_t = grid_layout::params_t;
+
+    level_context(random_t& random, params_t const& params)
+      : random {random}
+      , params {params}
+      , grid   {static_cast<size_t>(params.field_w), static_cast<size_t>(params.field_h)}
+    {
+    }
+
+    tez::arena                 arena; //!< first; outlives everything allocated from it
+    random_t&                  random;
+    params_t                   params;
+    std::vector<room_rect_set> room_defs;
+    std::vector<room_polygon>  rooms; //!< room_defs[i] as a polygon
+    tile_grid                  grid;
+};
+
+//==============================================================================
+//! The default level generation stages.
+//==============================================================================
+namespace level_stage {
+
+//------------------------------------------------------------------------------
+//! Generate the room rects.
+//------------------------------------------------------------------------------
+inline void layout(level_context& context) {
+    context.room_defs = grid_layout{}(context.params, context.random, &context.arena);
+}
+
+//------------------------------------------------------------------------------
+//! Build the polygon of each room: the union of its rects minus the union of
+//! its holes. A hole only removes floor from its own room.
+//------------------------------------------------------------------------------
+inline void carve_holes(level_context& context) {
+    auto const& defs  = context.room_defs;
+    auto&       rooms = context.rooms;
+
+    tez::arena_allocator<int> const alloc {&context.arena};
+
+    rooms.clear();
+    rooms.reserve(defs.size());
+
+    for (auto const& def : defs) {
+        rooms.emplace_back(def, alloc);
+    }
+}
+
+//------------------------------------------------------------------------------
+//! Fill each room polygon with floor tagged with the room id (index + 1); one
+//! contiguous fill per span. Later rooms are drawn over earlier ones.
+//------------------------------------------------------------------------------
+inline void rasterize(level_context& context) {
+    tile_data tile_floor;
+    tile_floor.type = tile_data::tile_type::floor;
+
+    auto const& rooms = context.rooms;
+    auto&       grid  = context.grid;
+
+    for (size_t i = 0; i < rooms.size(); ++i) {
+        tile_floor.room_id = static_cast<tile_data::room_id_t>(i + 1);
+
+        rooms[i].for_each_span([&](int const y, int const x0, int const x1) {
+            grid.fill_span(y, x0, x1, tile_floor);
+        });
+    }
+}
+
+//------------------------------------------------------------------------------
+//! Carve an L shaped corridor from @p a to @p b; empty tiles become
+//! @p corridor, everything else is left as is.
+//------------------------------------------------------------------------------
+inline void carve_corridor(
+    tile_grid& grid
+  , room_rect_set::point_t a
+  , room_rect_set::point_t const b
+  , tile_data const& corridor
+  , bool const horizontal_first
+) {
+    auto const carve = [&] {
+        auto& tile = grid.at(a.x, a.y);
+        if (tile.type == tile_data::tile_type::empty) {
+            tile = corridor;
+        }
+    };
+
+    auto const step_x = [&] {
+        for (; a.x != b.x; a.x += (b.x > a.x) ? 1 : -1) carve();
+    };
+
+    auto const step_y = [&] {
+        for (; a.y != b.y; a.y += (b.y > a.y) ? 1 : -1) carve();
+    };
+
+    if (horizontal_first) {
+        step_x(); step_y();
+    } else {
+        step_y(); step_x();
+    }
+
+    carve();
+}
+
+//------------------------------------------------------------------------------
+//! Connect rooms along a minimum spanning tree of the graph joining each room
+//! center to its nearest neighbours, plus a few of the remaining edges for
+//! loops. Corridors are carved directly, so every room is reachable and the
+//! cost doesn't depend on luck.
+//------------------------------------------------------------------------------
+inline void connect(level_context& context) {
+    static size_t const NEIGHBORS         = 4;
+    static float  const EXTRA_EDGE_CHANCE = 0.15f;
+
+    using point_t = room_rect_set::point_t;
+
+    struct edge_t {
+        int    weight;
+        size_t a;
+        size_t b;
+
+        bool operator<(edge_t const& rhs) const BK_NOEXCEPT {
+            return std::tie(weight, a, b) < std::tie(rhs.weight, rhs.a, rhs.b);
+        }
+
+        bool operator==(edge_t const& rhs) const BK_NOEXCEPT {
+            return a == rhs.a && b == rhs.b;
+        }
+    };
+
+    auto const& rooms = context.room_defs;
+    auto const  n     = rooms.size();
+
+    if (n < 2) {
+        return;
+    }
+
+    tez::arena_allocator<edge_t> const alloc {&context.arena};
+
+    tez::arena_vector<point_t> centers(alloc);
+    centers.reserve(n);
+
+    for (auto const& room : rooms) {
+        centers.emplace_back(room.px(0, 0), room.py(0, 0));
+    }
+
+    auto const distance = [&](size_t const i, size_t const j) {
+        auto const dx = centers[i].x - centers[j].x;
+        auto const dy = centers[i].y - centers[j].y;
+        return dx*dx + dy*dy;
+    };
+
+    auto const make_edge = [&](size_t const i, size_t const j) {
+        return edge_t {distance(i, j), std::min(i, j), std::max(i, j)};
+    };
+
+    //--------------------------------------------------------------------------
+    // k nearest neighbours; O(n^2) but n is the number of rooms.
+    //--------------------------------------------------------------------------
+    auto const k = std::min(NEIGHBORS, n - 1);
+
+    tez::arena_vector<edge_t> edges(alloc);
+    tez::arena_vector<edge_t> nearest(alloc);
+    edges.reserve(n * k);
+    nearest.reserve(n - 1);
+
+    for (size_t i = 0; i < n; ++i) {
+        nearest.clear();
+
+        for (size_t j = 0; j < n; ++j) {
+            if (i != j) {
+                nearest.push_back(make_edge(i, j));
+            }
+        }
+
+        std::partial_sort(std::begin(nearest), std::begin(nearest) + k, std::end(nearest));
+        edges.insert(std::end(edges), std::begin(nearest), std::begin(nearest) + k);
+    }
+
+    std::sort(std::begin(edges), std::end(edges));
+    edges.erase(std::unique(std::begin(edges), std::end(edges)), std::end(edges));
+
+    //--------------------------------------------------------------------------
+    // Kruskal
+    //--------------------------------------------------------------------------
+    bklib::basic_disjoint_set<tez::arena_allocator<size_t>> sets {n, alloc};
+
+    tez::arena_vector<edge_t> chosen(alloc);
+    chosen.reserve(n * 2);
+
+    std::uniform_real_distribution<float> extra_gen;
+
+    size_t tree_edges = 0;
+
+    for (auto const& e : edges) {
+        if (sets.unite(e.a, e.b)) {
+            chosen.push_back(e);
+            ++tree_edges;
+        } else if (extra_gen(context.random) < EXTRA_EDGE_CHANCE) {
+            chosen.push_back(e);
+        }
+    }
+
+    //the neighbour graph can be split into clusters; join them over the
+    //complete graph.
+    if (tree_edges < n - 1) {
+        edges.clear();
+
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = i + 1; j < n; ++j) {
+                if (sets.find(i) != sets.find(j)) {
+                    edges.push_back(make_edge(i, j));
+                }
+            }
+        }
+
+        std::sort(std::begin(edges), std::end(edges));
+
+        for (auto const& e : edges) {
+            if (sets.unite(e.a, e.b)) {
+                chosen.push_back(e);
+            }
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    // carve
+    //--------------------------------------------------------------------------
+    tile_data corridor;
+    corridor.type = tile_data::tile_type::corridor;
+
+    std::bernoulli_distribution horizontal_gen;
+
+    for (auto const& e : chosen) {
+        corridor.room_id = static_cast<tile_data::room_id_t>(e.a + 1);
+
+        carve_corridor(context.grid, centers[e.a], centers[e.b], corridor
+          , horizontal_gen(context.random));
+    }
+}
+
+//------------------------------------------------------------------------------
+//! Connect rooms with directed walks; each room walks out of one side, trying
+//! the others until a walk reaches another room. Rooms can be left
+//! disconnected; replaced by connect in the default pipeline.
+//------------------------------------------------------------------------------
+inline void connect_walks(level_context& context) {
+    static int const vx[] {0,  0, 1, -1};
+    static int const vy[] {1, -1, 0,  0};
+    std::uniform_int_distribution<> dir_gen {0, 3};
+
+    auto const& rooms = context.room_defs;
+
+    for (size_t i = 0; i < rooms.size(); ++i) {
+        auto const& cell = rooms[i];
+
+        auto const start_dir = dir_gen(context.random);
+
+        for (int j = 0; j < 4; ++j) {
+            auto const dir = (start_dir + j) % 4;
+
+            auto const dx = vx[dir];
+            auto const dy = vy[dir];
+
+            auto result = directed_walk {}(
+                context.random, context.grid, i+1
+              , cell.px(dx, dy), cell.py(dx, dy)
+              , dx, dy
+              , &context.arena
+            );
+
+            if (result.size() > 1) {
+                break;
+            }
+        }
+    }
+}
+
+} //namespace level_stage
+
+//==============================================================================
+//! An ordered list of named level generation stages.
+//!
+//! Records the wall time and the allocations (see tez::thread_allocations) of
+//! each stage; stages can be replaced by name.
+//==============================================================================
+class level_pipeline {
+public:
+    using stage_t = std::function<void (level_context&)>;
+
+    struct stats_t {
+        double time_ms           = 0.0;
+        size_t allocations       = 0; //!< heap allocations
+        size_t bytes             = 0; //!< heap bytes
+        size_t arena_allocations = 0; //!< allocations from the context arena
+        size_t arena_bytes       = 0; //!< bytes from the context arena
+
+        stats_t& operator+=(stats_t const& rhs) BK_NOEXCEPT {
+            time_ms           += rhs.time_ms;
+            allocations       += rhs.allocations;
+            bytes             += rhs.bytes;
+            arena_allocations += rhs.arena_allocations;
+            arena_bytes       += rhs.arena_bytes;
+            return *this;
+        }
+    };
+
+    struct stage_info {
+        std::string name;
+        stage_t     stage;
+        stats_t     last;  //!< stats for the most recent run
+        stats_t     total; //!< stats summed over every run
+    };
+
+    //--------------------------------------------------------------------------
+    //! layout -> carve_holes -> rasterize -> connect
+    //--------------------------------------------------------------------------
+    static level_pipeline make_default() {
+        level_pipeline result;
+
+        result.add("layout",      level_stage::layout);
+        result.add("carve_holes", level_stage::carve_holes);
+        result.add("rasterize",   level_stage::rasterize);
+        result.add("connect",     level_stage::connect);
+
+        return result;
+    }
+
+    //--------------------------------------------------------------------------
+    //! Append @p stage as @p name.
+    //--------------------------------------------------------------------------
+    void add(std::string name, stage_t stage) {
+        stage_info info;
+        info.name  = std::move(name);
+        info.stage = std::move(stage);
+
+        stages_.push_back(std::move(info));
+    }
+
+    //--------------------------------------------------------------------------
+    //! Replace the stage called @p name with @p stage.
+    //! @returns false if there is no such stage.
+    //--------------------------------------------------------------------------
+    bool replace(std::string const& name, stage_t stage) {
+        auto const where = std::find_if(std::begin(stages_), std::end(stages_)
+          , [&](stage_info const& info) { return info.name == name; });
+
+        if (where == std::end(stages_)) {
+            return false;
+        }
+
+        where->stage = std::move(stage);
+        return true;
+    }
+
+    //--------------------------------------------------------------------------
+    //! Run every stage, in order, on @p context.
+    //--------------------------------------------------------------------------
+    void run(level_context& context) {
+        using clock_t = std::chrono::high_resolution_clock;
+        using ms      = std::chrono::duration<double, std::milli>;
+
+        auto& arena = context.arena;
+
+        for (auto& info : stages_) {
+            auto const n0 = arena.allocations();
+            auto const b0 = arena.bytes_allocated();
+            auto const a0 = tez::thread_allocations();
+            auto const t0 = clock_t::now();
+
+            info.stage(context);
+
+            auto const t1 = clock_t::now();
+            auto const a  = tez::thread_allocations() - a0;
+
+            info.last.time_ms           = ms(t1 - t0).count();
+            info.last.allocations       = a.count;
+            info.last.bytes             = a.bytes;
+            info.last.arena_allocations = arena.allocations() - n0;
+            info.last.arena_bytes       = arena.bytes_allocated() - b0;
+
+            info.total += info.last;
+        }
+    }
+
+    std::vector<stage_info> const& stages() const BK_NOEXCEPT {
+        return stages_;
+    }
+private:
+    std::vector<stage_info> stages_;
+};
+
+struct level {
+    using random_t = tez::random_t;
+    using params_t = grid_layout::params_t;
+
+    explicit level(random_t& random, params_t const params = params_t{})
+      : params_ {params}
+      , grid_ {static_cast<size_t>(params.field_w), static_cast<size_t>(params.field_h)}
+    {
+        generate(random);
+    }
+
+    level(random_t& random, params_t const params, level_pipeline& pipeline)
+      : params_ {params}
+      , grid_ {static_cast<size_t>(params.field_w), static_cast<size_t>(params.field_h)}
+    {
+        generate(random, pipeline);
+    }
+
+    //! a level from already generated parts; see level_cache.
+    level(params_t const params, std::vector<room_rect_set>&& rooms, tile_grid&& grid)
+      : params_    {params}
+      , room_defs_ (std::move(rooms))
+      , grid_      (std::move(grid))
+    {
+    }
+
+    void generate(random_t& random) {
+        auto pipeline = level_pipeline::make_default();
+        generate(random, pipeline);
+    }
+
+    void generate(random_t& random, level_pipeline& pipeline) {
+        level_context context {random, params_};
+
+        pipeline.run(context);
+
+        room_defs_ = std::move(context.room_defs);
+        grid_      = std::move(context.grid);
+    }
+
+    params_t                   params_;
+    std::vector<room_rect_set> room_defs_;
+    tile_grid                  grid_;
+};
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "level.hpp"
+
+namespace tez {
+
+//==============================================================================
+//! An on-disk cache of generated levels.
+//!
+//! Levels are keyed by a hash of (LEVEL_GENERATOR_VERSION, params, seed), so
+//! bumping the generator version or changing any parameter that affects the
+//! output is a miss rather than a stale hit. Each level is one file holding
+//! its rooms and its run length encoded tiles.
+//!
+//! The total size of the files is kept under @c max_bytes by evicting the
+//! least recently used levels. The recency order is kept in an index file in
+//! the cache directory; it is written by flush() and on destruction. Levels
+//! stored since the index was last written (before a crash, say) are found
+//! by scanning the directory when the cache is opened.
+//!
+//! Safe to use from several threads at once.
+//==============================================================================
+class level_cache {
+public:
+    using params_t = level::params_t;
+    using key_t    = uint64_t;
+
+    static size_t const DEFAULT_MAX_BYTES = 64 * 1024 * 1024;
+
+    level_cache(level_cache const&) = delete;
+    level_cache& operator=(level_cache const&) = delete;
+
+    //--------------------------------------------------------------------------
+    //! Open (or create) the cache in @p directory; the directory is created
+    //! if it does not exist, but its parent must.
+    //--------------------------------------------------------------------------
+    explicit level_cache(std::string directory, size_t max_bytes = DEFAULT_MAX_BYTES);
+
+    ~level_cache();
+
+    //--------------------------------------------------------------------------
+    //! The key for the level generated with @p params from @p seed. The
+    //! thread count does not affect the output, so it is not part of the key.
+    //--------------------------------------------------------------------------
+    static key_t key_of(uint64_t seed, params_t const& params);
+
+    //--------------------------------------------------------------------------
+    //! Read the level for @p key into @p out; out.params_ is kept.
+    //! @returns false on a miss, or if the file is unreadable; unreadable
+    //! files are dropped.
+    //--------------------------------------------------------------------------
+    bool load(key_t key, level& out);
+
+    //--------------------------------------------------------------------------
+    //! Write @p lvl as the level for @p key, then evict down to max_bytes.
+    //--------------------------------------------------------------------------
+    void store(key_t key, level const& lvl);
+
+    //--------------------------------------------------------------------------
+    //! The cached level for (@p seed, @p params); on a miss, @c generate() is
+    //! called for it and the result stored.
+    //--------------------------------------------------------------------------
+    template <typename Generate>
+    level fetch(uint64_t const seed, params_t const& params, Generate generate) {
+        auto const key = key_of(seed, params);
+
+        level result {params, std::vector<room_rect_set> {}, tile_grid {0, 0}};
+        if (load(key, result)) {
+            return result;
+        }
+
+        result = generate();
+        store(key, result);
+
+        return result;
+    }
+
+    //! remove every cached level.
+    void clear();
+
+    //! write the index.
+    void flush() const;
+
+    size_t size()   const;
+    size_t bytes()  const;
+    size_t hits()   const;
+    size_t misses() const;
+private:
+    struct entry_t {
+        size_t                     bytes;
+        std::list<key_t>::iterator where;   //!< position in lru_
+        uint64_t                   version; //!< changes each time the file is stored
+    };
+
+    std::string path_of_(key_t key) const;
+    std::string index_path_() const;
+
+    void read_index_();
+    void write_index_() const;
+
+    //! record @p key, with its file at @p version, as the most recently
+    //! used; lock held.
+    void touch_(key_t key, size_t bytes, uint64_t version);
+    //! forget @p key and delete its file; lock held.
+    void erase_(key_t key);
+    //! evict least recently used levels down to max_bytes_; lock held.
+    void evict_();
+
+    std::string directory_;
+    size_t      max_bytes_;
+
+    mutable std::mutex                  mutex_;
+    std::list<key_t>                    lru_;   //!< most recently used first
+    std::unordered_map<key_t, entry_t>  index_;
+    size_t                              bytes_        = 0;
+    size_t                              hits_         = 0;
+    size_t                              misses_       = 0;
+    uint64_t                            next_version_ = 0;
+};
+
+} //namespace tez
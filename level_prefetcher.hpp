@@ -0,0 +1,106 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "level.hpp"
+#include "level_cache.hpp"
+
+namespace tez {
+
+//==============================================================================
+//! Speculative generation of levels on background threads.
+//!
+//! The level at a given depth is always generated from
+//! make_stream(world_seed, depth), so a prefetched level is identical to one
+//! generated on demand. At most @c capacity levels are held at once (queued,
+//! in progress or ready); levels the player can no longer reach are dropped
+//! with retain().
+//!
+//! With a level_cache, levels are read from it when present and stored to it
+//! when generated; the cache key is derive_seed(world_seed, depth).
+//==============================================================================
+class level_prefetcher {
+public:
+    using params_t = level::params_t;
+    using depth_t  = int;
+
+    level_prefetcher(level_prefetcher const&) = delete;
+    level_prefetcher& operator=(level_prefetcher const&) = delete;
+
+    level_prefetcher(
+        uint64_t world_seed
+      , params_t params   = params_t{}
+      , size_t   capacity = 4
+      , unsigned threads  = 1
+      , level_cache* cache = nullptr
+    );
+
+    ~level_prefetcher();
+
+    //--------------------------------------------------------------------------
+    //! Schedule the level at @p depth.
+    //! @returns false if it is already scheduled or there is no free slot.
+    //--------------------------------------------------------------------------
+    bool prefetch(depth_t depth);
+
+    //--------------------------------------------------------------------------
+    //! Cancel every prefetch not in @p depths. Queued levels are dropped
+    //! immediately; levels in progress are discarded when they finish.
+    //--------------------------------------------------------------------------
+    void retain(std::initializer_list<depth_t> depths);
+
+    //--------------------------------------------------------------------------
+    //! Take the level at @p depth. Waits for it if it is in progress;
+    //! otherwise generates it on the calling thread. If generating it on a
+    //! worker threw, the exception is rethrown here.
+    //--------------------------------------------------------------------------
+    level take(depth_t depth);
+
+    //--------------------------------------------------------------------------
+    //! Generate the level at @p depth on the calling thread.
+    //--------------------------------------------------------------------------
+    level generate(depth_t depth) const {
+        return generate_(depth, params_);
+    }
+
+    //! number of slots in use.
+    size_t size() const;
+private:
+    enum class state_t {
+        queued, running, ready
+    };
+
+    struct slot_t {
+        state_t                state     = state_t::queued;
+        bool                   cancelled = false;
+        std::unique_ptr<level> result;
+        std::exception_ptr     error; //!< thrown instead of making result
+    };
+
+    level generate_(depth_t depth, params_t const& params) const;
+
+    void work_();
+
+    uint64_t world_seed_;
+    params_t params_;
+    size_t   capacity_;
+
+    level_cache* cache_;
+
+    mutable std::mutex        mutex_;
+    std::condition_variable   work_cv_;
+    std::condition_variable   done_cv_;
+    std::deque<depth_t>       queue_;
+    std::map<depth_t, slot_t> slots_;
+    bool                      stop_ = false;
+
+    std::vector<std::thread> workers_;
+};
+
+} //namespace tez
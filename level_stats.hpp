@@ -0,0 +1,100 @@
+#pragma once
+
+#include "level.hpp"
+
+namespace tez {
+
+//==============================================================================
+//! Summary of a generated level; see analyze().
+//==============================================================================
+struct level_stats {
+    size_t tiles          = 0; //!< width * height
+    size_t floor_tiles    = 0;
+    size_t corridor_tiles = 0; //!< the total corridor length
+    size_t dead_ends      = 0; //!< corridor tiles with one walkable neighbor
+    size_t room_count     = 0;
+    size_t min_room_area  = 0; //!< floor area of the smallest room; 0 without rooms
+
+    //! pairs of rooms whose rects overlap.
+    size_t overlapping_rooms = 0;
+
+    //! the size of each 4-connected component of walkable (floor or corridor)
+    //! tiles, largest first.
+    std::vector<size_t> component_sizes;
+
+    //! floor tiles / tiles.
+    double floor_ratio() const BK_NOEXCEPT {
+        return tiles ? static_cast<double>(floor_tiles) / tiles : 0.0;
+    }
+
+    bool is_connected() const BK_NOEXCEPT {
+        return component_sizes.size() <= 1;
+    }
+};
+
+//==============================================================================
+//! Compute the stats of @p lvl in one sweep over its tiles, plus a sweep line
+//! over its room rects for overlaps.
+//==============================================================================
+level_stats analyze(level const& lvl);
+
+//==============================================================================
+//! Thresholds a level must meet to be accepted; see find_defects().
+//==============================================================================
+struct level_limits {
+    double min_floor_ratio       = 0.10;
+    size_t min_rooms             = 4;
+    size_t min_room_area         = 4;
+    size_t max_components        = 1;
+    size_t max_overlapping_rooms = std::numeric_limits<size_t>::max();
+    size_t max_dead_ends         = std::numeric_limits<size_t>::max();
+};
+
+//! what find_defects() found wrong with a level; a bitmask.
+enum : uint32_t {
+    LEVEL_OK                = 0
+  , LEVEL_SPARSE            = 1 << 0
+  , LEVEL_TOO_FEW_ROOMS     = 1 << 1
+  , LEVEL_TINY_ROOM         = 1 << 2
+  , LEVEL_DISCONNECTED      = 1 << 3
+  , LEVEL_OVERLAPPING_ROOMS = 1 << 4
+  , LEVEL_DEAD_ENDS         = 1 << 5
+};
+
+//==============================================================================
+//! The ways @p stats falls short of @p limits, or LEVEL_OK.
+//==============================================================================
+uint32_t find_defects(level_stats const& stats, level_limits const& limits = level_limits {});
+
+//==============================================================================
+//! A rejection filter: call @c generate(attempt) for attempt = 0, 1, ... until
+//! it returns a level without defects, or @p max_attempts are used up; the
+//! last level generated is returned either way.
+//!
+//! @p generate should derive its seed from @c attempt (make_stream(seed,
+//! attempt), say) so the accepted level is still a function of the seed.
+//==============================================================================
+template <typename Generate>
+level generate_valid(
+    Generate            generate
+  , level_limits const& limits       = level_limits {}
+  , size_t const        max_attempts = 8
+  , uint32_t*           defects      = nullptr
+) {
+    BK_ASSERT(max_attempts > 0);
+
+    for (size_t attempt = 0; ; ++attempt) {
+        auto result = generate(attempt);
+        auto const found = find_defects(analyze(result), limits);
+
+        if (found == LEVEL_OK || attempt + 1 >= max_attempts) {
+            if (defects) {
+                *defects = found;
+            }
+
+            return result;
+        }
+    }
+}
+
+} //namespace tez
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <unordered_map>
+
+#include "loot_table.hpp"
+
+namespace tez {
+
+//==============================================================================
+//! The exact drop rate of one item for one roll of a table.
+//==============================================================================
+struct loot_item_rate {
+    item_ref item;
+    double   expected;    //!< the mean number dropped
+    double   probability; //!< the chance that at least one is dropped
+};
+
+//! sorted by item.
+using loot_rates = std::vector<loot_item_rate>;
+
+//==============================================================================
+//! The probability of each count a distribution can draw, with every count
+//! <= 0 folded into index 0 (they all drop nothing). Normal and poisson tails
+//! beyond any count with probability > 1e-12 are dropped.
+//==============================================================================
+std::vector<double> count_probabilities(distribution const& dist);
+
+//==============================================================================
+//! Computes the exact drop rates of linked loot tables; see link_loot_tables.
+//!
+//! Entry probabilities come from the alias slots the tables roll with, and
+//! nested tables are analysed once and memoised, so a whole set of tables
+//! costs about one pass over their entries times the items they can drop.
+//! Results stay valid as long as the tables do; off the thread that reclaims
+//! loot_table_table, hold a snapshot() of them for as long as the analyzer is
+//! used.
+//==============================================================================
+class loot_analyzer {
+public:
+    loot_rates const& operator()(loot_table const& table);
+
+    //! the rate of @p item in @p table; zero if it is never dropped.
+    loot_item_rate rate(loot_table const& table, item_ref item);
+
+    void clear() { memo_.clear(); }
+private:
+    std::unordered_map<loot_table const*, loot_rates> memo_;
+};
+
+} //namespace tez
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "loot_table.hpp"
+
+namespace tez {
+
+//==============================================================================
+//! @c count copies of @c item: one run of the items of a roll.
+//==============================================================================
+struct loot_drop {
+    item_ref item;
+    int      count;
+};
+
+//==============================================================================
+//! The output of batched rolls, and the scratch space they reuse; clear() it
+//! and keep it between batches so rolling allocates nothing once warm.
+//==============================================================================
+struct loot_batch {
+    struct frame {
+        uint32_t table;
+        int      remaining;
+    };
+
+    std::vector<loot_drop> drops; //!< the drops of every roll, in order
+    std::vector<uint32_t>  ends;  //!< the end of the drops of each roll
+    std::vector<frame>     stack; //!< scratch
+
+    void clear() {
+        drops.clear();
+        ends.clear();
+    }
+
+    //! the number of rolls.
+    size_t size() const BK_NOEXCEPT { return ends.size(); }
+
+    loot_drop const* begin(size_t const roll) const {
+        BK_ASSERT(roll < size());
+        return drops.data() + (roll ? ends[roll - 1] : 0);
+    }
+
+    loot_drop const* end(size_t const roll) const {
+        BK_ASSERT(roll < size());
+        return drops.data() + ends[roll];
+    }
+};
+
+//==============================================================================
+//! A set of linked loot tables compiled into flat arrays and rolled by a
+//! non-recursive interpreter.
+//!
+//! Each table is a contiguous run of alias slots and, in parallel, of
+//! instructions; rolling a table picks one instruction from its run (the
+//! pick), draws its count, then either emits the item count times or pushes
+//! a frame that repeats the target table count times. Nested tables cost a
+//! stack of small loops instead of a call per level.
+//!
+//! Rolls make the same draws, in the same order, as loot_table::roll, so both
+//! give the same items for the same generator.
+//==============================================================================
+class loot_program {
+public:
+    using item_list = loot_table::item_list;
+
+    enum class op : uint8_t {
+        emit   //!< add item, count times
+      , repeat //!< roll table, count times
+      , skip   //!< an unlinked reference; draws the count and does nothing
+    };
+
+    struct instruction {
+        op           code  = op::skip;
+        uint32_t     table = 0;  //!< for repeat
+        item_ref     item  {0};  //!< for emit
+        distribution count {};
+    };
+
+    //! one pending repeat of the interpreter.
+    using frame   = loot_batch::frame;
+    using stack_t = std::vector<frame>;
+
+    static uint32_t const NO_TABLE = 0xFFFFFFFFu;
+
+    loot_program() = default;
+
+    //--------------------------------------------------------------------------
+    //! Compile every table of @p tables, which must be linked; see
+    //! link_loot_tables.
+    //--------------------------------------------------------------------------
+    explicit loot_program(loot_table_table::container_t const& tables);
+
+    //--------------------------------------------------------------------------
+    //! The index of the table with id @p ref, or NO_TABLE.
+    //--------------------------------------------------------------------------
+    uint32_t find(hash_wrapper<detail::tag_loot_table> ref) const;
+
+    //--------------------------------------------------------------------------
+    //! Roll the table at @p table once, appending to @p items; @p stack is
+    //! scratch space, reused between calls.
+    //--------------------------------------------------------------------------
+    void roll(uint32_t table, random_t& random, item_list& items, stack_t& stack) const;
+
+    item_list roll(uint32_t table, random_t& random) const;
+
+    //--------------------------------------------------------------------------
+    //! Roll the table at @p table @p times times, appending one roll per time
+    //! to @p out. Consecutive drops of the same item within a roll are joined.
+    //--------------------------------------------------------------------------
+    void roll(uint32_t table, size_t times, random_t& random, loot_batch& out) const;
+
+    //--------------------------------------------------------------------------
+    //! Roll each of the @p count tables at @p tables once, in order, appending
+    //! one roll per table to @p out.
+    //--------------------------------------------------------------------------
+    void roll(uint32_t const* tables, size_t count, random_t& random, loot_batch& out) const;
+
+    size_t table_count()       const BK_NOEXCEPT { return tables_.size(); }
+    size_t instruction_count() const BK_NOEXCEPT { return code_.size(); }
+private:
+    //calls emit(item_ref, count) for every item drop of one roll of table.
+    template <typename Emit>
+    void run_(uint32_t table, random_t& random, stack_t& stack, Emit&& emit) const;
+
+    void roll_once_(uint32_t table, random_t& random, loot_batch& out) const;
+
+    struct table_t {
+        uint32_t first; //!< the first of its slots and instructions
+        uint32_t size;
+    };
+
+    std::vector<table_t>             tables_;
+    std::vector<alias_table::slot_t> slots_;
+    std::vector<instruction>         code_;
+    flat_map<loot_table_ref, uint32_t> index_;
+};
+
+} //namespace tez
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "loot_table.hpp"
+
+namespace tez {
+
+//==============================================================================
+//! The drops of many simulated rolls of one table; see simulate_loot().
+//==============================================================================
+struct loot_simulation {
+    struct item_t {
+        item_ref item;
+        uint64_t total = 0; //!< dropped over all rolls
+
+        //! [k] is the number of rolls that dropped exactly k; [0] included.
+        std::vector<uint64_t> histogram;
+    };
+
+    uint64_t            rolls = 0;
+    std::vector<item_t> items; //!< sorted by item
+
+    item_t const* find(item_ref item) const;
+
+    //! the mean number of @p item dropped per roll.
+    double expected(item_ref item) const;
+
+    //! the fraction of rolls that dropped at least one @p item.
+    double probability(item_ref item) const;
+
+    //! add the rolls of @p other; sums only, so the order of merging does not
+    //! matter.
+    void merge(loot_simulation const& other);
+};
+
+bool operator==(loot_simulation const& lhs, loot_simulation const& rhs);
+
+//==============================================================================
+//! Roll @p table @p rolls times with loot_table::roll, on up to @p threads
+//! threads (0 for one per hardware thread).
+//!
+//! The rolls are split into fixed chunks, and chunk c rolls with stream c of
+//! derive_seed(@p seed, the table's id); each worker fills its own
+//! simulation, and the workers' simulations are merged at the end. The result
+//! depends only on the table, @p rolls and @p seed: not on @p threads, nor on
+//! which worker ran which chunk.
+//!
+//! @p table must outlive the call; off the thread that reclaims
+//! loot_table_table, pass an entry held for the call, as in
+//! simulate_loot(*loot_table_table::hold(id), ...).
+//==============================================================================
+loot_simulation simulate_loot(
+    loot_table const& table
+  , uint64_t          rolls
+  , uint64_t          seed
+  , unsigned          threads = 0
+);
+
+} //namespace tez
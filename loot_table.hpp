@@ -11,14 +11,14 @@
 
 #include "types.hpp"
 #include "util.hpp"
+#include "random.hpp"
+#include "alias_table.hpp"
 
 #include <bklib/types.hpp>
 #include <bklib/util.hpp>
 
 namespace tez {
 
-using random_t  = std::mt19937;
-
 namespace detail {
     struct tag_item;
     struct tag_loot_table;
@@ -27,64 +27,155 @@ namespace detail {
 using item_ref       = tagged_value<hash_t, detail::tag_item>;
 using loot_table_ref = tagged_value<hash_t, detail::tag_loot_table>;
 
+struct loot_linker;
+
 //==============================================================================
+//! A distribution of (item or roll) counts: a small tagged union with a
+//! switch-based draw; trivially copyable, never allocates.
 //==============================================================================
 class distribution {
 public:
+    enum class kind : uint8_t {
+        fixed    //!< always value
+      , uniform  //!< uniform in [min, max]
+      , normal   //!< normal(mean, stddev), rounded to the nearest integer
+      , binomial //!< successes in trials tries of probability p each
+      , poisson  //!< poisson(mean)
+    };
+
     template <typename T>
     static inline distribution make_uniform_int(T a, T b) {
-        return distribution{std::uniform_int_distribution<T>{a, b}};
+        distribution result {kind::uniform};
+        result.uniform_.min = static_cast<int32_t>(a);
+        result.uniform_.max = static_cast<int32_t>(b);
+        BK_ASSERT(result.uniform_.min <= result.uniform_.max);
+        return result;
     }
 
     template <typename T>
     static inline distribution make_normal(T mean, T stddev) {
-        return distribution{std::normal_distribution<>{
-            static_cast<double>(mean)
-          , static_cast<double>(stddev)
-        }};
+        distribution result {kind::normal};
+        result.normal_.mean   = static_cast<float>(mean);
+        result.normal_.stddev = static_cast<float>(stddev);
+        BK_ASSERT(result.normal_.stddev >= 0.0f);
+        return result;
     }
 
     template <typename T>
     static inline distribution make_fixed(T value) {
         return distribution{value};
     }
+
+    template <typename T>
+    static inline distribution make_binomial(T trials, double p) {
+        distribution result {kind::binomial};
+        result.binomial_.trials = static_cast<int32_t>(trials);
+        result.binomial_.p      = static_cast<float>(p);
+        BK_ASSERT(result.binomial_.trials >= 0);
+        BK_ASSERT(result.binomial_.p >= 0.0f && result.binomial_.p <= 1.0f);
+        return result;
+    }
+
+    template <typename T>
+    static inline distribution make_poisson(T mean) {
+        distribution result {kind::poisson};
+        result.poisson_.mean = static_cast<float>(mean);
+        BK_ASSERT(result.poisson_.mean >= 0.0f);
+        return result;
+    }
 public:
-    distribution()
-      : impl_{[](random_t& random) { return 0; }}
+    struct uniform_t  { int32_t min;    int32_t max; };
+    struct normal_t   { float   mean;   float   stddev; };
+    struct binomial_t { int32_t trials; float   p; };
+    struct poisson_t  { float   mean; };
+
+    distribution() BK_NOEXCEPT
+      : distribution{0}
     {
     }
 
     template <typename T>
     explicit distribution(std::uniform_int_distribution<T> dist)
-      : impl_{[dist](random_t& random) {
-            return static_cast<int>(dist(random)); //TODO
-        }}
+      : distribution{make_uniform_int(dist.a(), dist.b())}
     {
     }
 
     template <typename T>
     explicit distribution(std::normal_distribution<T> dist)
-      : impl_{[dist](random_t& random) mutable {
-            return static_cast<int>(std::round(dist(random))); //TODO
-        }}
+      : distribution{make_normal(dist.mean(), dist.stddev())}
     {
     }
 
     template <typename T, typename std::enable_if<std::is_arithmetic<T>::value>::type* = 0>
-    explicit distribution(T value)
-      : impl_{[value](random_t& random) {
-            return static_cast<int>(value); //TODO
-        }}
+    explicit distribution(T value) BK_NOEXCEPT
+      : kind_ {kind::fixed}
     {
+        fixed_ = static_cast<int32_t>(value);
     }
 
     int operator()(random_t& random) const {
-        return impl_(random);
+        switch (kind_) {
+        case kind::fixed :
+            return fixed_;
+        case kind::uniform : {
+            //the span wraps to 0 for the full range of int32_t
+            auto const span = static_cast<uint32_t>(uniform_.max) - static_cast<uint32_t>(uniform_.min) + 1u;
+            auto const r    = span ? random_below(random, span) : static_cast<uint32_t>(random());
+            return static_cast<int>(static_cast<uint32_t>(uniform_.min) + r);
+        }
+        case kind::normal :
+            if (normal_.stddev <= 0.0f) {
+                return static_cast<int>(std::round(normal_.mean));
+            }
+
+            //drawn in double, as before distribution held float parameters,
+            //so the engine is advanced the same way
+            return static_cast<int>(std::round(std::normal_distribution<double> {
+                static_cast<double>(normal_.mean), static_cast<double>(normal_.stddev)
+            }(random)));
+        case kind::binomial :
+            return std::binomial_distribution<int> {binomial_.trials, binomial_.p}(random);
+        case kind::poisson :
+            if (poisson_.mean <= 0.0f) {
+                return 0;
+            }
+
+            return std::poisson_distribution<int> {poisson_.mean}(random);
+        }
+
+        BK_ASSERT(false);
+        return 0;
     }
+
+    kind type() const BK_NOEXCEPT { return kind_; }
+
+    int32_t    fixed()    const { BK_ASSERT(kind_ == kind::fixed);    return fixed_; }
+    uniform_t  uniform()  const { BK_ASSERT(kind_ == kind::uniform);  return uniform_; }
+    normal_t   normal()   const { BK_ASSERT(kind_ == kind::normal);   return normal_; }
+    binomial_t binomial() const { BK_ASSERT(kind_ == kind::binomial); return binomial_; }
+    poisson_t  poisson()  const { BK_ASSERT(kind_ == kind::poisson);  return poisson_; }
 private:
-    std::function<int (random_t&)> impl_;
+    explicit distribution(kind const type) BK_NOEXCEPT
+      : kind_ {type}
+    {
+        uniform_.min = 0;
+        uniform_.max = 0;
+    }
+
+    kind kind_;
+
+    union {
+        int32_t    fixed_;
+        uniform_t  uniform_;
+        normal_t   normal_;
+        binomial_t binomial_;
+        poisson_t  poisson_;
+    };
 };
 
+static_assert(std::is_trivially_copyable<distribution>::value, "");
+static_assert(sizeof(distribution) <= 16, "");
+
 //==============================================================================
 //==============================================================================
 class loot_table {
@@ -106,6 +197,10 @@ public:
 
         value_t      value = item_ref{0};
         distribution count = distribution{};
+
+        //! the table a loot_table_ref refers to; set by link_loot_tables, and
+        //! left null if the reference is dangling or would close a cycle.
+        loot_table const* table = nullptr;
     };
 
     using table_entries = std::vector<entry>;
@@ -113,17 +208,24 @@ public:
     using history_t     = boost::container::flat_set<loot_table_ref>;
     using weights_t     = std::vector<double>;
 
+    //! @pre @p weights has one weight >= 0 per entry, and they sum to > 0.
     loot_table(utf8string id, table_entries&& entries, weights_t const& weights);
+    loot_table(utf8string id, table_entries&& entries, alias_table&& picker);
     loot_table() = default;
 
-    item_list roll(random_t& random);
-    void      roll(random_t& random, item_list& items, history_t& history);
+    item_list roll(random_t& random) const;
+    void      roll(random_t& random, item_list& items, history_t& history) const;
 
     loot_table_ref reference() const { return loot_table_ref {id_.hash}; }
     string_ref id() const { return {id_.string}; }
+
+    table_entries const& entries() const BK_NOEXCEPT { return entries_; }
+    alias_table   const& picker()  const BK_NOEXCEPT { return picker_; }
 private:
-    table_entries                entries_ {{}};
-    std::discrete_distribution<> distribution_ = std::discrete_distribution<>{};
+    friend struct loot_linker;
+
+    table_entries      entries_ {{}};
+    alias_table        picker_  {};   //!< picks an index into entries_
     tez::hashed_string id_ {{""}};
 };
 
@@ -136,7 +238,7 @@ private:
 // ENTRY_WEIGHT  -> unsigned
 // ENTRY_TYPE    -> string
 // ENTRY_ID      -> string
-// ENTRY_DIST    -> DIST_UNIFORM | DIST_NORMAL | DIST_FIXED
+// ENTRY_DIST    -> DIST_UNIFORM | DIST_NORMAL | DIST_FIXED | DIST_BINOMIAL | DIST_POISSON
 // DIST_UNIFORM  -> ["uniform", DIST_MIN, DIST_MAX]
 // DIST_MIN      -> unsigned
 // DIST_MAX      -> unsigned
@@ -145,6 +247,10 @@ private:
 // DIST_STDDEV   -> unsigned
 // DIST_FIXED    -> ["fixed", DIST_VALUE]
 // DIST_VALUE    -> unsigned
+// DIST_BINOMIAL -> ["binomial", DIST_TRIALS, DIST_PERCENT]
+// DIST_TRIALS   -> unsigned
+// DIST_PERCENT  -> unsigned; the chance of each trial, in [0, 100]
+// DIST_POISSON  -> ["poisson", DIST_MEAN]
 
 struct loot_table_parser : public parser_base<loot_table_parser> {
     using cref = bklib::json::cref;
@@ -169,12 +275,16 @@ struct loot_table_parser : public parser_base<loot_table_parser> {
     bool rule_dist_uniform(utf8string const& id, cref json_value);
     bool rule_dist_normal(utf8string const& id ,cref json_value);
     bool rule_dist_fixed(utf8string const& id, cref json_value);
+    bool rule_dist_binomial(utf8string const& id, cref json_value);
+    bool rule_dist_poisson(utf8string const& id, cref json_value);
 
     void rule_dist_min(cref json_value);
     void rule_dist_max(cref json_value);
     void rule_dist_mean(cref json_value);
     void rule_dist_stddev(cref json_value);
     void rule_dist_value(cref json_value);
+    void rule_dist_trials(cref json_value);
+    void rule_dist_percent(cref json_value);
 
     using map_t = boost::container::flat_map<loot_table_ref, loot_table>;
 
@@ -191,6 +301,8 @@ struct loot_table_parser : public parser_base<loot_table_parser> {
     int                        dist_mean_    {0};
     int                        dist_stddev_  {0};
     int                        dist_value_   {0};
+    int                        dist_trials_  {0};
+    int                        dist_percent_ {0};
 
     map_t tables_ = {{}};
 };
@@ -201,7 +313,7 @@ struct loot_table_parser : public parser_base<loot_table_parser> {
 namespace detail {
     template <> struct tag_traits<tag_loot_table> {
         using type    = loot_table;
-        using pointer = loot_table*;
+        using pointer = loot_table const*;
         using ref     = loot_table_ref;
         using parser  = loot_table_parser;
     };
@@ -210,6 +322,48 @@ namespace detail {
 extern template data_table<detail::tag_loot_table>;
 using loot_table_table = data_table<detail::tag_loot_table>;
 
+//==============================================================================
+//! A bad reference found by link_loot_tables.
+//==============================================================================
+struct loot_link_error {
+    enum class kind {
+        dangling_table //!< no table has the referenced id
+      , dangling_item  //!< no item has the referenced id; only checked if the
+                       //!< item_table is loaded
+      , cycle          //!< the referenced table (indirectly) refers back
+    };
+
+    kind           type;
+    loot_table_ref table;  //!< the table with the bad entry
+    hash_t         target; //!< the id the entry refers to
+};
+
+using loot_link_errors = std::vector<loot_link_error>;
+
+//==============================================================================
+//! Resolve the loot_table_ref of every entry of @p tables to a pointer into
+//! @p tables, so rolling never looks a table up by id.
+//!
+//! Entries with a dangling reference, or that close a cycle, are left
+//! unlinked (and roll nothing); the tables form a DAG afterwards. @p tables
+//! must not be modified after linking.
+//==============================================================================
+loot_link_errors link_loot_tables(loot_table_table::container_t& tables);
+
+//==============================================================================
+//! Link the loaded loot tables again and publish them as a new snapshot,
+//! reporting what link_loot_tables finds; call after item_table is reloaded,
+//! from the thread that reloads the loot tables, so entries are checked
+//! against the new items.
+//! @returns false if no loot tables are loaded.
+//==============================================================================
+bool relink_loot_tables();
+
+namespace detail {
+    //! links the tables and reports any errors; see data_table::reload.
+    void link_table(tag_loot_table*, loot_table_table::container_t& tables);
+} //namespace detail
+
 inline string_ref ref_to_id(loot_table_ref ref) {
     auto const loot_table = loot_table_table::get(ref);
 
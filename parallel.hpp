@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace tez {
+
+//==============================================================================
+//! The number of worker threads to use for a requested count of @p threads;
+//! 0 means one per hardware thread.
+//==============================================================================
+inline unsigned worker_count(unsigned const threads) {
+    if (threads) {
+        return threads;
+    }
+
+    auto const n = std::thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+//==============================================================================
+//! Call @c function(i) for every i in [0, @p n) using up to @p threads threads.
+//!
+//! Indicies are handed out dynamically, so @c function must not depend on the
+//! order in which indicies are processed. Exceptions are rethrown on the
+//! calling thread.
+//!
+//! @tparam Function Unary function(size_t).
+//==============================================================================
+template <typename Function>
+void parallel_for(size_t const n, unsigned const threads, Function function) {
+    auto const workers = static_cast<size_t>(worker_count(threads));
+
+    if (workers <= 1 || n <= 1) {
+        for (size_t i = 0; i < n; ++i) {
+            function(i);
+        }
+
+        return;
+    }
+
+    std::atomic<size_t> next {0};
+
+    auto const work = [&] {
+        for (auto i = next++; i < n; i = next++) {
+            function(i);
+        }
+    };
+
+    std::vector<std::future<void>> results;
+    results.reserve(workers - 1);
+
+    for (size_t i = 1; i < workers && i < n; ++i) {
+        results.emplace_back(std::async(std::launch::async, work));
+    }
+
+    work();
+
+    for (auto& result : results) {
+        result.get();
+    }
+}
+
+} //namespace tez
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+
+#include <bklib/config.hpp>
+#include <bklib/assert.hpp>
+
+#include "grid2d.hpp"
+#include "tile_data.hpp"
+#include "types.hpp"
+
+namespace tez {
+
+//==============================================================================
+//! The 8 symmetries of a rectangle: a clockwise rotation, optionally applied
+//! after mirroring left to right.
+//==============================================================================
+enum class orientation : uint8_t {
+    r0, r90, r180, r270
+  , mirror_r0, mirror_r90, mirror_r180, mirror_r270
+
+  , COUNT
+};
+
+//==============================================================================
+//! A pre-rasterized room.
+//!
+//! Every orientation is rasterized once, up front, so that placing a prefab is
+//! a plain copy of each of its rows.
+//==============================================================================
+class prefab {
+public:
+    using grid_t = grid2d<tile_data>;
+
+    prefab(prefab const&) = delete;
+    prefab& operator=(prefab const&) = delete;
+
+    prefab(prefab&& other);
+    prefab& operator=(prefab&& rhs);
+
+    prefab() = default;
+
+    explicit prefab(grid_t const& source);
+
+    grid_t const& get(orientation const o = orientation::r0) const {
+        BK_ASSERT(o < orientation::COUNT);
+        return variants_[static_cast<size_t>(o)];
+    }
+
+    size_t width(orientation const o = orientation::r0)  const { return get(o).width(); }
+    size_t height(orientation const o = orientation::r0) const { return get(o).height(); }
+
+    //--------------------------------------------------------------------------
+    //! Copy the prefab, in orientation @p o, into @p dest with its top left
+    //! corner at (@p x, @p y).
+    //! @pre the prefab must fit inside @p dest.
+    //--------------------------------------------------------------------------
+    void stamp(
+        grid_t& dest, size_t const x, size_t const y
+      , orientation const o = orientation::r0
+    ) const {
+        blit(get(o), dest, x, y);
+    }
+private:
+    std::array<grid_t, static_cast<size_t>(orientation::COUNT)> variants_;
+};
+
+} //namespace tez
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <random>
+#include <cstdint>
+
+#include <bklib/config.hpp>
+
+namespace tez {
+
+using random_t = std::mt19937;
+
+//==============================================================================
+//! The SplitMix64 output function; a cheap bijective mix of @p x.
+//==============================================================================
+inline uint64_t splitmix64(uint64_t x) BK_NOEXCEPT {
+    x += 0x9E3779B97F4A7C15ull;
+    x  = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x  = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+//==============================================================================
+//! Counter based seed derivation: the seed for stream @p index of @p seed.
+//!
+//! Stateless, so any stream can be created without creating the streams
+//! before it; this is what lets per-cell (or per-level, per-chunk, ...) work
+//! run in any order, on any thread, and still give the same result.
+//==============================================================================
+inline uint64_t derive_seed(uint64_t const seed, uint64_t const index) BK_NOEXCEPT {
+    return splitmix64(seed ^ splitmix64(index));
+}
+
+//==============================================================================
+//! Draw a 64 bit seed from @p random.
+//==============================================================================
+inline uint64_t make_seed(random_t& random) {
+    auto const hi = static_cast<uint64_t>(random());
+    auto const lo = static_cast<uint64_t>(random());
+    return (hi << 32) | lo;
+}
+
+//==============================================================================
+//! A uniform draw in [0, @p n) from @p random, which must produce full 32 bit
+//! values; Lemire's multiply-shift, with rejection so there is no bias.
+//==============================================================================
+inline uint32_t random_below(random_t& random, uint32_t const n) {
+    static_assert(random_t::min() == 0 && random_t::max() == 0xFFFFFFFFu
+      , "expects full 32 bit draws");
+
+    auto m = static_cast<uint64_t>(random()) * n;
+    auto l = static_cast<uint32_t>(m);
+
+    if (l < n) {
+        auto const t = static_cast<uint32_t>(0u - n) % n;
+        while (l < t) {
+            m = static_cast<uint64_t>(random()) * n;
+            l = static_cast<uint32_t>(m);
+        }
+    }
+
+    return static_cast<uint32_t>(m >> 32);
+}
+
+//==============================================================================
+//! An independent generator for stream @p index of @p seed.
+//==============================================================================
+inline random_t make_stream(uint64_t const seed, uint64_t const index) {
+    auto const s = derive_seed(seed, index);
+
+    std::seed_seq seq {
+        static_cast<uint32_t>(s & 0xFFFFFFFF)
+      , static_cast<uint32_t>(s >> 32)
+    };
+
+    return random_t {seq};
+}
+
+} //namespace tez
@@ -5,6 +5,9 @@
 
 #include <bklib/math.hpp>
 
+#include <map>
+#include <memory>
+
 #include "algorithms.hpp"
 #include "tile_data.hpp"
 #include "grid2d.hpp"
@@ -13,6 +16,8 @@ namespace tez {
 
 using random = std::mt19937;
 
+class prefab;
+
 //==============================================================================
 //! A single room.
 //==============================================================================
@@ -70,13 +75,23 @@ namespace generator {
 //! Generator for simple rectangular rooms of fixed size.
 //==============================================================================
 struct room_simple_fixed {
-    room_simple_fixed(unsigned w, unsigned h)
-      : width_{w}, height_{h} {}
+    //! builds the prefab; copies share it.
+    room_simple_fixed(unsigned w, unsigned h);
 
+    //--------------------------------------------------------------------------
+    //! The room, stamped from the prefab made when the generator was.
+    //--------------------------------------------------------------------------
     room generate(random& rand) const;
 
+    //--------------------------------------------------------------------------
+    //! The room, built tile by tile; what the prefab is made from.
+    //--------------------------------------------------------------------------
+    room build() const;
+
     unsigned width_;
     unsigned height_;
+
+    std::shared_ptr<prefab const> prefab_;
 };
 //==============================================================================
 //! Generator for simple rectangular rooms of random size.
@@ -88,10 +103,14 @@ struct room_simple {
     room_simple(range w, range h)
       : width_{w.first, w.second}, height_{h.first, h.second} {}
 
+    //! the room, stamped by a room_simple_fixed kept by this generator for
+    //! each size it has drawn.
     room generate(random& rand);
 
     distribution width_;
     distribution height_;
+
+    std::map<std::pair<unsigned, unsigned>, room_simple_fixed> fixed_;
 };
 
 //==============================================================================
@@ -144,18 +163,9 @@ struct layout_random {
         range_y_.min = 0;
     }
 
+    //! true if no two rects overlap.
     bool verify() const {
-        for (auto i = 0u; i < rects_.size(); ++i) {
-            for (auto j = i + 1; j < rects_.size(); ++j) {
-                auto const& a = rects_[i];
-                auto const& b = rects_[j];
-                if (bklib::intersects(a, b)) {
-                    return false;
-                }
-            }
-        }
-
-        return true;
+        return !bklib::any_intersecting_pair(rects_);
     }
 
     bool intersects(rect const r) const {
@@ -243,15 +253,7 @@ struct layout_random {
 
         for (size_t i = 0; i < rects_.size(); ++i) {
             auto const& rect = rects_[i];
-            auto const& room = data_[i];
-
-            for (auto const& tile_info : room) {
-                auto pos = tile_info.i;
-                pos.x += rect.left();
-                pos.y += rect.top();
-
-                result[pos] = tile_info.value;
-            }
+            blit(data_[i], result, rect.left(), rect.top());
         }
 
         return result;
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include "arena.hpp"
+
+TEST(Arena, Alignment) {
+    tez::arena arena {64};
+
+    for (size_t align = 1; align <= 32; align *= 2) {
+        arena.allocate(1, 1);
+        auto const p = arena.allocate(3, align);
+        ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(p) % align);
+    }
+
+    //bigger than a block
+    auto const big = arena.allocate(1000, 16);
+    ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(big) % 16);
+    ASSERT_LE(1000u, arena.bytes_reserved());
+}
+
+TEST(Arena, ResetKeepsLargestBlock) {
+    tez::arena arena {64};
+
+    for (int i = 0; i < 100; ++i) {
+        arena.allocate(48, 8);
+    }
+
+    ASSERT_EQ(100u,      arena.allocations());
+    ASSERT_EQ(100u * 48, arena.bytes_allocated());
+    ASSERT_LT(1u,        arena.block_count());
+
+    arena.reset();
+
+    ASSERT_EQ(0u, arena.allocations());
+    ASSERT_EQ(0u, arena.bytes_allocated());
+    ASSERT_EQ(1u, arena.block_count());
+
+    //fits in the kept block
+    auto const reserved = arena.bytes_reserved();
+    arena.allocate(reserved / 2, 8);
+    ASSERT_EQ(1u, arena.block_count());
+}
+
+TEST(Arena, Allocator) {
+    tez::arena arena;
+
+    tez::arena_vector<int> v {tez::arena_allocator<int> {&arena}};
+    for (int i = 0; i < 1000; ++i) {
+        v.push_back(i);
+    }
+
+    ASSERT_EQ(999, v.back());
+    ASSERT_LT(0u, arena.allocations());
+
+    //no arena; uses the heap
+    tez::arena_vector<int> heap;
+    heap.assign(std::begin(v), std::end(v));
+    ASSERT_EQ(nullptr, heap.get_allocator().get_arena());
+    ASSERT_TRUE(v == heap);
+}
+
+TEST(Arena, CopiesUseTheHeap) {
+    tez::arena arena;
+
+    tez::arena_vector<int> v {tez::arena_allocator<int> {&arena}};
+    v.assign(100, 7);
+
+    auto const copy = v;
+    ASSERT_EQ(nullptr, copy.get_allocator().get_arena());
+    ASSERT_EQ(&arena, v.get_allocator().get_arena());
+
+    //the copy survives the arena being reset and reused
+    v.clear();
+    v.shrink_to_fit();
+    arena.reset();
+
+    tez::arena_vector<int> reuse {tez::arena_allocator<int> {&arena}};
+    reuse.assign(100, 9);
+
+    ASSERT_EQ(100u, copy.size());
+    ASSERT_TRUE(std::all_of(std::begin(copy), std::end(copy), [](int const i) { return i == 7; }));
+}
+
+TEST(Arena, ConcurrentAllocations) {
+    tez::arena arena {256};
+
+    size_t const threads = 4;
+    size_t const n       = 2000;
+
+    std::vector<std::vector<char*>> results(threads);
+    std::vector<std::thread>        workers;
+
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            for (size_t i = 0; i < n; ++i) {
+                auto const p = static_cast<char*>(arena.allocate(24, 8));
+                std::fill_n(p, 24, static_cast<char>(t));
+                results[t].push_back(p);
+            }
+        });
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    ASSERT_EQ(threads * n,      arena.allocations());
+    ASSERT_EQ(threads * n * 24, arena.bytes_allocated());
+
+    //nothing handed out twice, and nothing overwritten by another thread
+    std::vector<char*> all;
+    for (size_t t = 0; t < threads; ++t) {
+        for (auto const p : results[t]) {
+            ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(p) % 8);
+            ASSERT_TRUE(std::all_of(p, p + 24, [&](char const c) { return c == static_cast<char>(t); }));
+            all.push_back(p);
+        }
+    }
+
+    std::sort(std::begin(all), std::end(all));
+    ASSERT_TRUE(std::adjacent_find(std::begin(all), std::end(all)
+      , [](char const* a, char const* b) { return b - a < 24; }) == std::end(all));
+}
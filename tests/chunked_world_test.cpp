@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include "chunked_world.hpp"
+
+#include "level_compare.hpp"
+
+namespace {
+
+bool is_walkable(tile_data const& tile) {
+    return tile.type == tile_data::tile_type::floor
+        || tile.type == tile_data::tile_type::corridor;
+}
+
+} //namespace
+
+TEST(ChunkedWorld, ChunkIsIndependentOfOrder) {
+    using key_t = tez::chunked_world::key_t;
+
+    tez::chunked_world a {42};
+    tez::chunked_world b {42};
+
+    a.require(0, 0, 150);
+    auto const& expected = a.chunk(key_t {-1, 1});
+
+    //generated cold, and after unloading
+    ASSERT_TRUE(test::same_tiles(expected.grid_, b.chunk(key_t {-1, 1}).grid_));
+    b.evict(1000, 1000, 0);
+    ASSERT_FALSE(b.is_loaded(key_t {-1, 1}));
+    ASSERT_TRUE(test::same_tiles(expected.grid_, b.chunk(key_t {-1, 1}).grid_));
+}
+
+TEST(ChunkedWorld, SeamsMatch) {
+    tez::chunked_world world {1984};
+
+    auto const w = world.chunk_w();
+    auto const h = world.chunk_h();
+
+    for (int cy = -2; cy <= 2; ++cy) {
+        for (int cx = -2; cx <= 2; ++cx) {
+            tez::chunked_world::key_t const key {cx, cy};
+
+            //west edge of this chunk and east edge of its neighbour
+            auto const y = cy * h + world.portal_w(key);
+            ASSERT_TRUE(is_walkable(world.at(cx * w,     y)));
+            ASSERT_TRUE(is_walkable(world.at(cx * w - 1, y)));
+
+            //north edge of this chunk and south edge of its neighbour
+            auto const x = cx * w + world.portal_n(key);
+            ASSERT_TRUE(is_walkable(world.at(x, cy * h)));
+            ASSERT_TRUE(is_walkable(world.at(x, cy * h - 1)));
+        }
+    }
+}
+
+TEST(ChunkedWorld, LoadsOnlyNearbyChunks) {
+    tez::chunked_world world {10};
+
+    auto const w = world.chunk_w();
+    auto const h = world.chunk_h();
+
+    world.require(w / 2, h / 2, 1);
+    ASSERT_EQ(1, world.size());
+
+    world.require(w, h / 2, 1);
+    ASSERT_EQ(2, world.size());
+
+    world.evict(w + w / 2, h / 2, 1);
+    ASSERT_EQ(1, world.size());
+    ASSERT_TRUE(world.is_loaded(tez::chunked_world::key_t {1, 0}));
+}
@@ -0,0 +1,235 @@
+#include <gtest/gtest.h>
+
+#include "data_pack.hpp"
+
+namespace {
+
+char const ITEMS[] = R"({"items": [
+{   "id": "cheese"
+  , "category": "consumable"
+  , "type": "food"
+  , "tags": ["animal_product", "milk_product"]
+  , "weight": 10
+  , "base_value": 100
+  , "attributes": [["nutrition", 100], ["crit_mult", 1.5], ["dmg_type", "blunt"]]
+  , "name": [["en", "cheese"], ["jp", "チーズ"]]
+  , "description": [["en", "Delicious and creamy."]]
+},
+{   "id": "apple"
+  , "category": "consumable"
+  , "type": "food"
+  , "tags": ["fruit"]
+  , "weight": 2
+  , "base_value": 10
+  , "attributes": []
+  , "name": [["en", "apple"]]
+  , "description": [["en", "cheese"]]
+}
+]})";
+
+char const TABLES[] = R"({ "tables": [
+    {"id": "food",   "table": [[1, "item", "apple"], [3, "item", "cheese", ["uniform", 1, 4]]]},
+    {"id": "common", "table": [[2, "table", "food", ["poisson", 2]], [1, "item", "apple"]]}
+]})";
+
+tez::data_pack make_pack() {
+    tez::data_pack pack;
+
+    {
+        std::istringstream in {ITEMS};
+        tez::item_parser parser {in};
+        parser.parse();
+        pack.items = parser.get();
+    }
+
+    {
+        std::istringstream in {TABLES};
+        tez::loot_table_parser parser {in};
+        parser.parse();
+        pack.loot_tables = parser.get();
+    }
+
+    tez::link_loot_tables(pack.loot_tables);
+
+    return pack;
+}
+
+std::string write_pack(tez::data_pack const& pack) {
+    std::ostringstream out;
+    tez::write_data_pack(out, pack.items, pack.loot_tables);
+    return out.str();
+}
+
+template <typename T>
+void set_header(std::string& bytes, size_t const offset, T const value) {
+    std::memcpy(&bytes[offset], &value, sizeof(T));
+}
+
+//! replace the only occurrence of the bytes of @p from in @p bytes.
+template <typename T>
+bool replace_bytes(std::string& bytes, T const& from, T const& to) {
+    std::string const a {reinterpret_cast<char const*>(&from), sizeof(T)};
+    std::string const b {reinterpret_cast<char const*>(&to),   sizeof(T)};
+
+    auto const where = bytes.find(a);
+    if (where == std::string::npos || bytes.find(a, where + 1) != std::string::npos) {
+        return false;
+    }
+
+    bytes.replace(where, a.size(), b);
+    return true;
+}
+
+#pragma pack(push, 1)
+struct uniform_bytes {
+    uint8_t kind;
+    int32_t min;
+    int32_t max;
+};
+#pragma pack(pop)
+
+} //namespace
+
+TEST(DataPack, RoundTrips) {
+    auto const source = make_pack();
+    auto const bytes  = write_pack(source);
+
+    tez::data_pack pack;
+    ASSERT_TRUE(tez::read_data_pack(bytes.data(), bytes.size(), pack));
+
+    ASSERT_EQ(source.items.size(), pack.items.size());
+
+    for (auto const& value : source.items) {
+        auto const where = pack.items.find(value.first);
+        ASSERT_NE(std::end(pack.items), where);
+
+        auto const& a = value.second;
+        auto const& b = where->second;
+
+        ASSERT_EQ(a.id.string, b.id.string);
+        ASSERT_EQ(a.id.hash, b.id.hash);
+        ASSERT_EQ(a.category, b.category);
+        ASSERT_EQ(a.type, b.type);
+        ASSERT_EQ(a.weight, b.weight);
+        ASSERT_EQ(a.base_value, b.base_value);
+        ASSERT_TRUE(a.tags == b.tags);
+        ASSERT_TRUE(a.names.strings() == b.names.strings());
+        ASSERT_TRUE(a.descriptions.strings() == b.descriptions.strings());
+
+        ASSERT_EQ(a.attributes.size(), b.attributes.size());
+        for (auto i = a.attributes.begin(), j = b.attributes.begin(); i != a.attributes.end(); ++i, ++j) {
+            ASSERT_EQ(i->name(), j->name());
+            ASSERT_EQ(i->kind(), j->kind());
+
+            switch (i->kind()) {
+            case tez::item_attribute::type::integer :
+                ASSERT_EQ(i->int_value(), j->int_value()); break;
+            case tez::item_attribute::type::floating_point :
+                ASSERT_EQ(i->float_value(), j->float_value()); break;
+            case tez::item_attribute::type::string :
+                ASSERT_EQ(i->string_value(), j->string_value()); break;
+            }
+        }
+    }
+
+    ASSERT_EQ(source.loot_tables.size(), pack.loot_tables.size());
+    tez::link_loot_tables(pack.loot_tables);
+
+    for (auto const& value : source.loot_tables) {
+        auto const where = pack.loot_tables.find(value.first);
+        ASSERT_NE(std::end(pack.loot_tables), where);
+        ASSERT_EQ(value.second.id(), where->second.id());
+
+        //same slots and counts, so the same rolls
+        tez::random_t a {7};
+        tez::random_t b {7};
+
+        for (int i = 0; i < 1000; ++i) {
+            ASSERT_EQ(value.second.roll(a), where->second.roll(b));
+        }
+    }
+}
+
+TEST(DataPack, RejectsBadPacks) {
+    auto const bytes = write_pack(make_pack());
+
+    tez::data_pack pack;
+
+    //every truncation
+    for (size_t n = 0; n < bytes.size(); ++n) {
+        ASSERT_FALSE(tez::read_data_pack(bytes.data(), n, pack));
+    }
+
+    auto other = bytes;
+    other[0] = 'X';
+    ASSERT_FALSE(tez::read_data_pack(other.data(), other.size(), pack));
+
+    other = bytes;
+    other[offsetof(tez::data_pack::header_t, version)] += 1;
+    ASSERT_FALSE(tez::read_data_pack(other.data(), other.size(), pack));
+
+    //counts more than the rest of the pack could hold
+    for (auto const offset : {offsetof(tez::data_pack::header_t, item_count)
+                            , offsetof(tez::data_pack::header_t, loot_table_count)}
+    ) {
+        for (uint32_t const count : {0xFFFFFFFFu, 0x10000000u, 1000u}) {
+            other = bytes;
+            set_header(other, offset, count);
+            ASSERT_FALSE(tez::read_data_pack(other.data(), other.size(), pack));
+        }
+    }
+
+    //a distribution no make_ function would build: uniform(4, 1)
+    uniform_bytes const good {static_cast<uint8_t>(tez::distribution::kind::uniform), 1, 4};
+    uniform_bytes const bad  {static_cast<uint8_t>(tez::distribution::kind::uniform), 4, 1};
+
+    other = bytes;
+    ASSERT_TRUE(replace_bytes(other, good, bad));
+    ASSERT_FALSE(tez::read_data_pack(other.data(), other.size(), pack));
+
+    //an unknown distribution
+    uniform_bytes const unknown {0xFF, 1, 4};
+
+    other = bytes;
+    ASSERT_TRUE(replace_bytes(other, good, unknown));
+    ASSERT_FALSE(tez::read_data_pack(other.data(), other.size(), pack));
+
+    //a table with no entries, which the parser would reject
+    auto empty = make_pack();
+    auto const ref = tez::loot_table_ref {bklib::utf8string_hash("empty")};
+    empty.loot_tables.emplace(ref, tez::loot_table {
+        "empty", {}, tez::alias_table::from_slots({})
+    });
+
+    other = write_pack(empty);
+    ASSERT_FALSE(tez::read_data_pack(other.data(), other.size(), pack));
+}
+
+TEST(DataPack, LoadPublishesTables) {
+    char const FILE_NAME[] = "./data_pack_test.pack";
+
+    {
+        auto const bytes = write_pack(make_pack());
+        std::ofstream out {FILE_NAME, std::ios::binary};
+        out.write(bytes.data(), bytes.size());
+    }
+
+    ASSERT_FALSE(tez::load_data_pack("./no_such_file.pack"));
+    ASSERT_TRUE(tez::load_data_pack(FILE_NAME));
+
+    auto const cheese = tez::item_table::get("cheese");
+    ASSERT_NE(nullptr, cheese);
+    ASSERT_EQ(tez::string_ref {"cheese"}, cheese->id.string);
+
+    auto const common = tez::loot_table_table::get("common");
+    ASSERT_NE(nullptr, common);
+    ASSERT_NE(nullptr, common->entries()[0].table);
+
+    //other tests expect no items to be loaded
+    tez::item_table::unload();
+    tez::loot_table_table::unload();
+
+    ASSERT_FALSE(tez::item_table::is_loaded());
+
+    std::remove(FILE_NAME);
+}
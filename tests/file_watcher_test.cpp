@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+
+#include "file_watcher.hpp"
+
+namespace {
+
+using duration = tez::file_watcher::duration;
+
+char const FILE_NAME[]  = "./file_watcher_test.def";
+char const OTHER_NAME[] = "file_watcher_test_other.def"; //same directory, spelt differently
+
+void write_file(char const* const text, char const* const name = FILE_NAME) {
+    std::ofstream out {name, std::ios::trunc};
+    out << text;
+}
+
+//! a count of callbacks that can be waited on.
+struct counter {
+    void operator()(tez::utf8string const&) {
+        std::lock_guard<std::mutex> lock {mutex};
+        ++count;
+        cv.notify_all();
+    }
+
+    int get() {
+        std::lock_guard<std::mutex> lock {mutex};
+        return count;
+    }
+
+    bool wait_for(int const n, duration const timeout = duration {5000}) {
+        std::unique_lock<std::mutex> lock {mutex};
+        return cv.wait_for(lock, timeout, [&] { return count >= n; });
+    }
+
+    std::mutex              mutex;
+    std::condition_variable cv;
+    int                     count = 0;
+};
+
+} //namespace
+
+TEST(FileWatcher, CallsBackOnChange) {
+    write_file("a");
+
+    counter calls;
+
+    //a generous settle, so the burst below is one call however slowly the
+    //machine writes it
+    auto const settle = duration {500};
+
+    tez::file_watcher watcher {settle, duration {20}};
+    watcher.watch(FILE_NAME, std::ref(calls));
+
+    std::this_thread::sleep_for(duration {50});
+    ASSERT_EQ(0, calls.get());
+
+    //sizes differ, for polling within the resolution of modification times
+    write_file("bb");
+    ASSERT_TRUE(calls.wait_for(1));
+
+    //a burst of writes settles into one call
+    write_file("ccc");
+    write_file("dddd");
+    write_file("eeeee");
+    ASSERT_TRUE(calls.wait_for(2));
+
+    std::this_thread::sleep_for(2 * settle);
+    ASSERT_EQ(2, calls.get());
+
+    std::remove(FILE_NAME);
+}
+
+TEST(FileWatcher, DeferredCallsWaitForDispatch) {
+    write_file("a");
+
+    auto const caller = std::this_thread::get_id();
+
+    int  calls       = 0;
+    bool same_thread = true;
+
+    tez::file_watcher watcher {duration {20}, duration {20}};
+    watcher.watch_deferred(FILE_NAME, [&](tez::utf8string const& path) {
+        ASSERT_EQ(tez::utf8string {FILE_NAME}, path);
+        same_thread = same_thread && std::this_thread::get_id() == caller;
+        ++calls;
+    });
+
+    write_file("bb");
+
+    size_t dispatched = 0;
+    for (int i = 0; i < 250 && !dispatched; ++i) {
+        std::this_thread::sleep_for(duration {20});
+        dispatched = watcher.dispatch();
+    }
+
+    ASSERT_EQ(1, dispatched);
+    ASSERT_EQ(1, calls);
+    ASSERT_TRUE(same_thread);
+
+    ASSERT_EQ(0, watcher.dispatch());
+
+    std::remove(FILE_NAME);
+}
+
+TEST(FileWatcher, SameDirectorySpeltDifferently) {
+    write_file("a");
+    write_file("a", OTHER_NAME);
+
+    counter calls;
+    counter other_calls;
+
+    tez::file_watcher watcher {duration {20}, duration {20}};
+    watcher.watch(FILE_NAME,  std::ref(calls));
+    watcher.watch(OTHER_NAME, std::ref(other_calls));
+
+    write_file("bb");
+    write_file("bb", OTHER_NAME);
+
+    ASSERT_TRUE(calls.wait_for(1));
+    ASSERT_TRUE(other_calls.wait_for(1));
+
+    std::remove(FILE_NAME);
+    std::remove(OTHER_NAME);
+}
+
+TEST(FileWatcher, MissingDirectory) {
+    write_file("a");
+
+    counter calls;
+    counter missing_calls;
+
+    //can't be watched by inotify; polled instead, and still nothing changes
+    tez::file_watcher watcher {duration {20}, duration {20}};
+    watcher.watch("./file_watcher_test_no_such_dir/file.def", std::ref(missing_calls));
+    watcher.watch(FILE_NAME, std::ref(calls));
+
+    write_file("bb");
+    ASSERT_TRUE(calls.wait_for(1));
+    ASSERT_EQ(0, missing_calls.get());
+
+    std::remove(FILE_NAME);
+}
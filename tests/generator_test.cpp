@@ -0,0 +1,424 @@
+#include <gtest/gtest.h>
+
+#include "level.hpp"
+#include "room.hpp"
+
+//==============================================================================
+// Golden-seed regression and timing suite for the level generators.
+//
+// Every case hashes the output of a generator for a fixed seed and params and
+// compares it with the hash recorded in the golden file; a mismatch means the
+// output drifted. The median wall time of each case is compared with the
+// recorded time as well; a case slower than TIMING_THRESHOLD times the
+// recorded time is reported, and fails the test when TEZ_STRICT_TIMING is set.
+//
+// Golden values are recorded per LEVEL_GENERATOR_VERSION and per standard
+// library, since the generators draw through std::*_distribution, whose
+// output differs between implementations. A case missing from the file fails;
+// when the file has no values at all for this version and standard library,
+// each golden test fails once saying so, rather than once per case.
+// With TEZ_UPDATE_GOLDEN set, the current values are written to the file
+// instead of compared; do that, and commit the file, after bumping
+// LEVEL_GENERATOR_VERSION for an intended change of output or when adding a
+// case or a standard library.
+//
+// The golden file is generators.golden next to this source file, found from
+// __FILE__ (tez_tests compiles with full paths), so the suite does not depend
+// on the working directory; TEZ_GOLDEN_FILE overrides it.
+//==============================================================================
+namespace {
+
+using hash64_t = uint64_t;
+
+char const   GOLDEN_FILE_NAME[] = "generators.golden";
+
+//! the standard library the golden values were recorded with.
+#if defined(_MSC_VER)
+char const   STDLIB[] = "msvc";
+#elif defined(_LIBCPP_VERSION)
+char const   STDLIB[] = "libc++";
+#elif defined(__GLIBCXX__)
+char const   STDLIB[] = "libstdc++";
+#else
+char const   STDLIB[] = "unknown";
+#endif
+double const TIMING_THRESHOLD      = 1.5;
+double const TIMING_SLACK_MS       = 0.25;
+int const    TIMING_RUNS           = 7;
+
+//! GOLDEN_FILE_NAME in the directory of this source file.
+std::string default_golden_file() {
+    std::string const source = __FILE__;
+
+    auto const i = source.find_last_of("/\\");
+    auto const directory = i == std::string::npos ? std::string {"./"} : source.substr(0, i + 1);
+
+    return directory + GOLDEN_FILE_NAME;
+}
+
+//------------------------------------------------------------------------------
+// FNV-1a
+//------------------------------------------------------------------------------
+struct hasher {
+    hash64_t value = 14695981039346656037ull;
+
+    template <typename T>
+    void operator()(T const& x) {
+        static_assert(std::is_integral<T>::value || std::is_enum<T>::value, "");
+
+        auto const bytes = reinterpret_cast<unsigned char const*>(&x);
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            value ^= bytes[i];
+            value *= 1099511628211ull;
+        }
+    }
+};
+
+hash64_t hash_of(std::vector<room_rect_set> const& rooms) {
+    hasher h;
+
+    auto const hash_rect = [&](room_rect_set::rect_t const& r) {
+        h(r.left()); h(r.top()); h(r.right()); h(r.bottom());
+    };
+
+    for (auto const& room : rooms) {
+        h(room.size());
+        for (auto const& value : room) {
+            hash_rect(value.base);
+            h(value.has_hole);
+            if (value.has_hole) {
+                hash_rect(value.hole);
+            }
+        }
+    }
+
+    return h.value;
+}
+
+hash64_t hash_of(tile_grid const& grid) {
+    hasher h;
+
+    h(grid.width());
+    h(grid.height());
+
+    for (auto const& tile : grid.tiles_) {
+        h(tile.type);
+        h(tile.room_id);
+    }
+
+    return h.value;
+}
+
+hash64_t hash_of(tez::generator::layout_random const& layout) {
+    hasher h;
+
+    for (auto const& r : layout.rects_) {
+        h(r.left()); h(r.top()); h(r.right()); h(r.bottom());
+    }
+
+    return h.value;
+}
+
+//------------------------------------------------------------------------------
+// golden file: one "<version> <stdlib> <case name> <hash> <time ms>" per line.
+//------------------------------------------------------------------------------
+class golden_file {
+public:
+    struct entry {
+        hash64_t hash;
+        double   time_ms;
+    };
+
+    golden_file() {
+        auto const env = std::getenv("TEZ_GOLDEN_FILE");
+        file_name_ = env ? std::string {env} : default_golden_file();
+        update_    = std::getenv("TEZ_UPDATE_GOLDEN") != nullptr;
+
+        std::ifstream in {file_name_};
+
+        unsigned    version;
+        std::string stdlib;
+        std::string name;
+        entry       e;
+
+        while (in >> version >> stdlib >> name >> std::hex >> e.hash >> std::dec >> e.time_ms) {
+            entries_[key_t {version, stdlib, name}] = e;
+
+            if (version == LEVEL_GENERATOR_VERSION && stdlib == STDLIB) {
+                recorded_ = true;
+            }
+        }
+    }
+
+    //! writes the file only when updating.
+    ~golden_file() {
+        if (!update_ || !dirty_) {
+            return;
+        }
+
+        std::ofstream out {file_name_};
+        if (!out) {
+            std::cout << "[ GOLDEN   ] could not write " << file_name_ << std::endl;
+            return;
+        }
+
+        for (auto const& kv : entries_) {
+            out << std::get<0>(kv.first) << " " << std::get<1>(kv.first) << " "
+                << std::get<2>(kv.first) << " "
+                << std::hex << kv.second.hash << std::dec << " "
+                << std::fixed << std::setprecision(4) << kv.second.time_ms << "\n";
+        }
+
+        std::cout << "[ GOLDEN   ] recorded " << file_name_ << std::endl;
+    }
+
+    //--------------------------------------------------------------------------
+    //! Compare (or record) @p hash and @p time_ms for the case @p name.
+    //--------------------------------------------------------------------------
+    void check(std::string const& name, hash64_t const hash, double const time_ms) {
+        auto const key   = key_t {LEVEL_GENERATOR_VERSION, STDLIB, name};
+        auto const where = entries_.find(key);
+
+        if (update_) {
+            entries_[key] = entry {hash, time_ms};
+            dirty_ = true;
+            return;
+        }
+
+        if (!recorded_) {
+            auto const test = ::testing::UnitTest::GetInstance()->current_test_info()->name();
+            if (reported_ != test) {
+                ADD_FAILURE() << "no golden values with " << STDLIB
+                    << " for generator version " << LEVEL_GENERATOR_VERSION
+                    << " in " << file_name_ << "; record them with TEZ_UPDATE_GOLDEN set";
+                reported_ = test;
+            }
+            return;
+        }
+
+        if (where == std::end(entries_)) {
+            ADD_FAILURE() << "no golden value for " << name << " with " << STDLIB
+                << " for generator version " << LEVEL_GENERATOR_VERSION
+                << " in " << file_name_ << "; record it with TEZ_UPDATE_GOLDEN set";
+            return;
+        }
+
+        auto const& expected = where->second;
+
+        EXPECT_EQ(expected.hash, hash)
+            << "output of " << name << " drifted from the golden value for "
+            << "generator version " << LEVEL_GENERATOR_VERSION;
+
+        auto const limit = expected.time_ms * TIMING_THRESHOLD + TIMING_SLACK_MS;
+        if (time_ms > limit) {
+            std::cout << "[ TIMING   ] " << name << " took " << time_ms
+                << " ms; recorded " << expected.time_ms << " ms" << std::endl;
+
+            if (std::getenv("TEZ_STRICT_TIMING")) {
+                ADD_FAILURE() << name << " timing regression";
+            }
+        }
+    }
+private:
+    using key_t = std::tuple<unsigned, std::string, std::string>;
+
+    std::string            file_name_;
+    std::map<key_t, entry> entries_;
+    bool                   update_   = false;
+    bool                   dirty_    = false;
+    bool                   recorded_ = false; //!< any values for this version and STDLIB
+    std::string            reported_;         //!< the last test failed for having none
+};
+
+golden_file& golden() {
+    static golden_file file;
+    return file;
+}
+
+//------------------------------------------------------------------------------
+//! Run @p function TIMING_RUNS times; return the hash of the last result and
+//! the median time in ms.
+//------------------------------------------------------------------------------
+template <typename Function>
+std::pair<hash64_t, double> measure(Function function) {
+    using clock_t = std::chrono::high_resolution_clock;
+    using ms      = std::chrono::duration<double, std::milli>;
+
+    std::vector<double> times;
+    hash64_t hash = 0;
+
+    for (int i = 0; i < TIMING_RUNS; ++i) {
+        auto const t0 = clock_t::now();
+        hash = function();
+        times.push_back(ms(clock_t::now() - t0).count());
+    }
+
+    std::sort(std::begin(times), std::end(times));
+    return {hash, times[times.size() / 2]};
+}
+
+uint32_t const SEEDS[] = {1, 10, 1984, 150123};
+
+grid_layout::params_t big_params() {
+    grid_layout::params_t p;
+    p.cell_size             = 20;
+    p.rect_max_size         = 19;
+    p.rect_size_mean        = 8.0f;
+    p.rects_per_cell_mean   = 3.0f;
+    p.field_w               = 200;
+    p.field_h               = 200;
+    p.cells_w               = p.field_w / p.cell_size;
+    p.cells_h               = p.field_h / p.cell_size;
+    return p;
+}
+
+std::string case_name(char const* stage, char const* params, uint32_t const seed) {
+    return std::string {stage} + "/" + params + "/" + std::to_string(seed);
+}
+
+} //namespace
+
+TEST(Generator, GridLayoutGolden) {
+    for (auto const seed : SEEDS) {
+        for (auto const& p : {std::make_pair("default", grid_layout::params_t {})
+                            , std::make_pair("big",     big_params())}
+        ) {
+            auto const result = measure([&] {
+                tez::random_t random {seed};
+                return hash_of(grid_layout{}(p.second, random));
+            });
+
+            golden().check(case_name("grid_layout", p.first, seed), result.first, result.second);
+        }
+    }
+}
+
+TEST(Generator, LevelGolden) {
+    for (auto const seed : SEEDS) {
+        for (auto const& p : {std::make_pair("default", grid_layout::params_t {})
+                            , std::make_pair("big",     big_params())}
+        ) {
+            auto const result = measure([&] {
+                tez::random_t random {seed};
+                return hash_of(level{random, p.second}.grid_);
+            });
+
+            golden().check(case_name("level", p.first, seed), result.first, result.second);
+        }
+    }
+}
+
+TEST(Generator, LayoutRandomGolden) {
+    for (auto const seed : SEEDS) {
+        auto const result = measure([&] {
+            tez::random rand {seed};
+            tez::generator::room_simple gen {{5u, 10u}, {3u, 7u}};
+            tez::generator::layout_random layout;
+
+            for (int i = 0; i < 50; ++i) {
+                layout.insert(rand, gen.generate(rand));
+            }
+
+            return hash_of(layout);
+        });
+
+        golden().check(case_name("layout_random", "default", seed), result.first, result.second);
+    }
+}
+
+TEST(Generator, LayoutPresetsMatchRuntime) {
+    using namespace layout_policy;
+
+    ASSERT_TRUE (matches<standard>(grid_layout::params_t {}));
+    ASSERT_TRUE (matches<large>(big_params()));
+    ASSERT_TRUE (matches<large>(large::params()));
+    ASSERT_FALSE(matches<standard>(big_params()));
+
+    for (auto const seed : SEEDS) {
+        for (auto const& p : {grid_layout::params_t {}, big_params()}) {
+            tez::random_t random1 {seed};
+            auto const preset = hash_of(grid_layout{}(p, seed, random1));
+
+            tez::random_t random2 {seed};
+            auto const fallback = hash_of(basic_grid_layout<runtime>{}(p, seed, random2));
+
+            ASSERT_EQ(fallback, preset);
+        }
+    }
+}
+
+TEST(Generator, PipelineStages) {
+    auto pipeline = level_pipeline::make_default();
+
+    bool connected = false;
+    ASSERT_TRUE(pipeline.replace("connect", [&](level_context& context) {
+        level_stage::connect(context);
+        connected = !context.room_defs.empty();
+    }));
+    ASSERT_FALSE(pipeline.replace("no such stage", level_stage::connect));
+
+    tez::random_t random1 {10};
+    level const expected {random1};
+
+    tez::random_t random2 {10};
+    level const result {random2, level::params_t {}, pipeline};
+
+    ASSERT_TRUE(connected);
+    ASSERT_EQ(hash_of(expected.grid_), hash_of(result.grid_));
+
+    auto const& stages = pipeline.stages();
+    ASSERT_EQ(4, stages.size());
+    ASSERT_EQ("layout", stages.front().name);
+    ASSERT_LT(0u, stages.front().last.allocations);
+}
+
+TEST(Generator, LevelIsConnected) {
+    using tile_type = tile_data::tile_type;
+
+    for (auto const seed : SEEDS) {
+        for (auto const& p : {grid_layout::params_t {}, big_params()}) {
+            tez::random_t random {seed};
+            level lvl {random, p};
+
+            auto const& grid = lvl.grid_;
+            auto const& rooms = lvl.room_defs_;
+            ASSERT_FALSE(rooms.empty());
+
+            auto const w = static_cast<int>(grid.width());
+            auto const h = static_cast<int>(grid.height());
+
+            //flood fill the walkable tiles from the first room's center
+            std::vector<char> seen(grid.tiles_.size(), 0);
+            std::vector<std::pair<int, int>> open {{rooms[0].px(0, 0), rooms[0].py(0, 0)}};
+
+            while (!open.empty()) {
+                auto const xy = open.back();
+                open.pop_back();
+
+                auto const x = xy.first;
+                auto const y = xy.second;
+
+                if (x < 0 || y < 0 || x >= w || y >= h || seen[y*w + x]) {
+                    continue;
+                }
+
+                auto const type = grid.at(x, y).type;
+                if (type != tile_type::floor && type != tile_type::corridor) {
+                    continue;
+                }
+
+                seen[y*w + x] = 1;
+
+                open.emplace_back(x + 1, y);
+                open.emplace_back(x - 1, y);
+                open.emplace_back(x, y + 1);
+                open.emplace_back(x, y - 1);
+            }
+
+            for (auto const& room : rooms) {
+                ASSERT_TRUE(seen[room.py(0, 0)*w + room.px(0, 0)] != 0)
+                    << "seed " << seed;
+            }
+        }
+    }
+}
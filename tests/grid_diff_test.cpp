@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include "grid_diff.hpp"
+#include "random.hpp"
+#include "tile_data.hpp"
+
+namespace {
+
+using grid_t   = tez::grid2d<tez::tile_data>;
+using hashes_t = tez::grid_chunk_hashes<tez::tile_data>;
+using patch_t  = tez::grid_patch<tez::tile_data>;
+
+grid_t make_base(size_t const w, size_t const h) {
+    grid_t result {w, h};
+
+    for (size_t y = 0; y < h; ++y) {
+        for (size_t x = 0; x < w; ++x) {
+            auto& tile = result.row(y)[x];
+            tile.type = ((x ^ y) & 3) ? tez::tile_type::floor : tez::tile_type::wall;
+            tile.data = x * 31 + y;
+        }
+    }
+
+    return result;
+}
+
+grid_t copy_of(grid_t const& grid) {
+    grid_t result {grid.width(), grid.height()};
+    tez::blit(grid, result, 0, 0);
+    return result;
+}
+
+bool same_grid(grid_t const& a, grid_t const& b) {
+    return a.width() == b.width() && a.height() == b.height()
+        && (a.size() == 0 || std::memcmp(a.row(0), b.row(0), a.size() * sizeof(tez::tile_data)) == 0);
+}
+
+} //namespace
+
+TEST(GridDiff, IdenticalGridsGiveEmptyPatch) {
+    auto const base    = make_base(100, 70);
+    auto const current = copy_of(base);
+
+    auto const patch = tez::make_patch(base, current);
+
+    ASSERT_TRUE(patch.empty());
+    ASSERT_TRUE(patch.values.empty());
+}
+
+TEST(GridDiff, PatchRoundTrip) {
+    auto const base = make_base(100, 70);
+    auto current    = copy_of(base);
+
+    hashes_t const base_hashes {base};
+    hashes_t current_hashes {current};
+
+    tez::random_t random {1984};
+    std::uniform_int_distribution<size_t> dist_x {0, 99};
+    std::uniform_int_distribution<size_t> dist_y {0, 69};
+
+    //scattered changes, plus a run crossing a chunk boundary
+    for (int i = 0; i < 40; ++i) {
+        auto const x = dist_x(random);
+        auto const y = dist_y(random);
+
+        current.row(y)[x].type = tez::tile_type::door;
+        current_hashes.rehash(current, x, y);
+    }
+
+    for (size_t x = 10; x < 40; ++x) {
+        current.row(5)[x].variation = 7;
+        current_hashes.rehash(current, x, 5);
+    }
+
+    ASSERT_FALSE(same_grid(base, current));
+
+    auto const patch = tez::make_patch(base, base_hashes, current, current_hashes);
+
+    //the same as hashing both from scratch
+    auto const full = tez::make_patch(base, current);
+    ASSERT_EQ(full.runs.size(), patch.runs.size());
+    ASSERT_EQ(full.values.size(), patch.values.size());
+
+    //runs are sorted, disjoint and joined across chunks
+    for (size_t i = 1; i < patch.runs.size(); ++i) {
+        ASSERT_LT(patch.runs[i - 1].offset + patch.runs[i - 1].length, patch.runs[i].offset);
+    }
+
+    ASSERT_GE(70u, patch.values.size());
+
+    auto restored = copy_of(base);
+    tez::apply_patch(patch, restored);
+    ASSERT_TRUE(same_grid(current, restored));
+
+    //serialized
+    std::stringstream buffer;
+    tez::write_patch(buffer, patch);
+
+    ASSERT_LT(buffer.str().size(), patch.values.size() * sizeof(tez::tile_data) + 256);
+
+    patch_t read;
+    ASSERT_TRUE(tez::read_patch(buffer, read));
+
+    auto restored2 = copy_of(base);
+    tez::apply_patch(read, restored2);
+    ASSERT_TRUE(same_grid(current, restored2));
+}
+
+TEST(GridDiff, ReadRejectsMalformed) {
+    auto const base = make_base(20, 20);
+    auto current    = copy_of(base);
+    current.row(19)[19].type = tez::tile_type::door;
+
+    std::stringstream buffer;
+    tez::write_patch(buffer, tez::make_patch(base, current));
+
+    auto const bytes = buffer.str();
+
+    patch_t patch;
+
+    std::istringstream truncated {bytes.substr(0, bytes.size() - 1)};
+    ASSERT_FALSE(tez::read_patch(truncated, patch));
+
+    std::istringstream bad_magic {"XXXX" + bytes.substr(4)};
+    ASSERT_FALSE(tez::read_patch(bad_magic, patch));
+}
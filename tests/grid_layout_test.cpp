@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+
+#include "level.hpp"
+
+#include "level_compare.hpp"
+
+namespace {
+
+grid_layout::params_t big_params() {
+    grid_layout::params_t p;
+    p.cell_size           = 20;
+    p.rect_max_size       = 19;
+    p.rect_size_mean      = 8.0f;
+    p.rects_per_cell_mean = 3.0f;
+    p.field_w             = 200;
+    p.field_h             = 200;
+    p.cells_w             = p.field_w / p.cell_size;
+    p.cells_h             = p.field_h / p.cell_size;
+    return p;
+}
+
+} //namespace
+
+TEST(GridLayout, ThreadCountInvariant) {
+    for (uint32_t const seed : {1u, 10u, 1984u, 150123u}) {
+        for (auto p : {grid_layout::params_t {}, big_params()}) {
+            p.thread_count = 1;
+
+            tez::random_t random1 {seed};
+            auto const serial = grid_layout{}(p, random1);
+            ASSERT_FALSE(serial.empty());
+
+            for (unsigned const threads : {2u, 3u, 4u, 8u, 0u}) {
+                p.thread_count = threads;
+
+                tez::random_t random {seed};
+                ASSERT_TRUE(test::same_rooms(serial, grid_layout{}(p, random)))
+                    << "seed " << seed << ", " << threads << " threads";
+            }
+        }
+    }
+}
+
+TEST(GridLayout, MergesChainsOfOverlaps) {
+    using rect_t = room_rect_set::rect_t;
+
+    //a meets b and b meets c, but a and c are disjoint; the same for d, e, f.
+    //the ends of each chain come first, so only b and e join them.
+    rect_t const a {0, 0, 4, 4},   b {3, 0, 7, 4},   c {6, 0, 10, 4};
+    rect_t const d {0, 10, 4, 14}, e {3, 10, 7, 14}, f {6, 10, 10, 14};
+
+    ASSERT_FALSE(bklib::intersects(a, c));
+    ASSERT_FALSE(bklib::intersects(d, f));
+
+    tez::arena_vector<room_rect_set> rooms;
+    for (auto const& r : {a, d, c, f, b, e}) {
+        rooms.emplace_back(r);
+    }
+
+    merge_intersecting(rooms);
+
+    ASSERT_EQ(2u, rooms.size());
+
+    for (auto const& room : rooms) {
+        ASSERT_EQ(3u, room.size());
+
+        auto const top = room.begin()->base.top();
+        ASSERT_TRUE(std::all_of(room.begin(), room.end(), [&](room_rect_set::value_t const& v) {
+            return v.base.top() == top;
+        }));
+    }
+
+    ASSERT_NE(rooms[0].begin()->base.top(), rooms[1].begin()->base.top());
+}
+
+TEST(GridLayout, ScratchComesFromTheArena) {
+    auto p = big_params();
+    p.rects_per_cell_mean   = 2.0f;
+    p.rects_per_cell_stddev = 0.01f;
+
+    tez::arena arena;
+    tez::random_t random {1984u};
+    auto const rooms = grid_layout{}(p, random, &arena);
+    ASSERT_FALSE(rooms.empty());
+
+    //every cell grows its own vector and holds two room_rect_sets; were the
+    //cells on the heap, only the outer vector would be in the arena.
+    size_t const cell_count = p.cells_w * p.cells_h;
+    ASSERT_LE(1 + 2 * cell_count, arena.allocations());
+
+    //the result is on the heap and the same as without an arena
+    tez::random_t heap_random {1984u};
+    ASSERT_TRUE(test::same_rooms(rooms, grid_layout{}(p, heap_random)));
+}
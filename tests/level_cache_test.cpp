@@ -0,0 +1,233 @@
+#include <gtest/gtest.h>
+
+#include "level_cache.hpp"
+
+#include "level_compare.hpp"
+
+#if BOOST_OS_WINDOWS
+#   include <direct.h>
+#else
+#   include <unistd.h>
+#endif
+
+namespace {
+
+char const CACHE_DIR[] = "./level_cache_test";
+
+level make_level(uint64_t const seed, level::params_t const& params = level::params_t {}) {
+    auto random = tez::make_stream(seed, 0);
+    return level {random, params};
+}
+
+level empty_level() {
+    return level {level::params_t {}, std::vector<room_rect_set> {}, tile_grid {0, 0}};
+}
+
+//! removes the cache directory, and the index the cache writes on closing.
+class LevelCache : public ::testing::Test {
+protected:
+    void TearDown() override {
+        {
+            tez::level_cache cache {CACHE_DIR};
+            cache.clear();
+        }
+
+        std::remove((std::string {CACHE_DIR} + "/index").c_str());
+
+    #if BOOST_OS_WINDOWS
+        _rmdir(CACHE_DIR);
+    #else
+        rmdir(CACHE_DIR);
+    #endif
+    }
+};
+
+} //namespace
+
+TEST_F(LevelCache, RoundTrip) {
+    tez::level_cache cache {CACHE_DIR};
+    cache.clear();
+
+    auto const expected = make_level(1);
+    auto const key      = tez::level_cache::key_of(1, expected.params_);
+
+    auto result = empty_level();
+    ASSERT_FALSE(cache.load(key, result));
+
+    cache.store(key, expected);
+    ASSERT_TRUE(cache.load(key, result));
+
+    ASSERT_TRUE(test::same_tiles(expected.grid_, result.grid_));
+    ASSERT_TRUE(test::same_rooms(expected.room_defs_, result.room_defs_));
+
+    //run length encoded; far smaller than the raw tiles
+    ASSERT_LT(cache.bytes(), expected.grid_.tiles_.size() * sizeof(tile_data) / 4);
+
+    cache.clear();
+}
+
+TEST_F(LevelCache, KeyDependsOnSeedAndParams) {
+    level::params_t p;
+    auto const key = tez::level_cache::key_of(1, p);
+
+    ASSERT_NE(key, tez::level_cache::key_of(2, p));
+
+    p.hole_probability = 0.5f;
+    ASSERT_NE(key, tez::level_cache::key_of(1, p));
+
+    //the output does not depend on the thread count
+    level::params_t q;
+    q.thread_count = 7;
+    ASSERT_EQ(key, tez::level_cache::key_of(1, q));
+}
+
+TEST_F(LevelCache, FetchGeneratesOnce) {
+    tez::level_cache cache {CACHE_DIR};
+    cache.clear();
+
+    int calls = 0;
+    auto const generate = [&] { ++calls; return make_level(5); };
+
+    auto const a = cache.fetch(5, level::params_t {}, generate);
+    auto const b = cache.fetch(5, level::params_t {}, generate);
+
+    ASSERT_EQ(1, calls);
+    ASSERT_EQ(1, cache.hits());
+    ASSERT_TRUE(test::same_tiles(a.grid_, b.grid_));
+
+    cache.clear();
+}
+
+TEST_F(LevelCache, EvictsLeastRecentlyUsed) {
+    size_t one = 0;
+    {
+        tez::level_cache cache {CACHE_DIR};
+        cache.clear();
+        cache.store(1, make_level(1));
+        one = cache.bytes();
+        cache.clear();
+    }
+
+    //room for two levels, give or take
+    tez::level_cache cache {CACHE_DIR, one * 5 / 2};
+
+    cache.store(1, make_level(1));
+    cache.store(2, make_level(2));
+
+    auto result = empty_level();
+    ASSERT_TRUE(cache.load(1, result)); //1 is now more recent than 2
+
+    cache.store(3, make_level(3));
+
+    ASSERT_EQ(2, cache.size());
+    ASSERT_TRUE (cache.load(1, result));
+    ASSERT_FALSE(cache.load(2, result));
+    ASSERT_TRUE (cache.load(3, result));
+
+    cache.clear();
+}
+
+TEST_F(LevelCache, Persists) {
+    auto const expected = make_level(9);
+    auto const key      = tez::level_cache::key_of(9, expected.params_);
+
+    {
+        tez::level_cache cache {CACHE_DIR};
+        cache.clear();
+        cache.store(key, expected);
+    }
+
+    tez::level_cache cache {CACHE_DIR};
+    ASSERT_EQ(1, cache.size());
+
+    auto result = empty_level();
+    ASSERT_TRUE(cache.load(key, result));
+    ASSERT_TRUE(test::same_tiles(expected.grid_, result.grid_));
+
+    cache.clear();
+}
+
+TEST_F(LevelCache, RejectsOtherSize) {
+    tez::level_cache cache {CACHE_DIR};
+    cache.clear();
+
+    auto const expected = make_level(5);
+    cache.store(5, expected);
+
+    //same key, but a level of another size is expected
+    auto params = expected.params_;
+    params.field_w /= 2;
+
+    auto result = level {params, std::vector<room_rect_set> {}, tile_grid {0, 0}};
+    ASSERT_FALSE(cache.load(5, result));
+    ASSERT_EQ(0, cache.size());
+
+    cache.clear();
+}
+
+TEST_F(LevelCache, FindsFilesMissingFromIndex) {
+    auto const index = std::string {CACHE_DIR} + "/index";
+
+    std::string flushed;
+
+    {
+        tez::level_cache cache {CACHE_DIR};
+        cache.clear();
+
+        cache.store(1, make_level(1));
+        cache.flush();
+
+        std::ifstream in {index};
+        flushed.assign(std::istreambuf_iterator<char> {in}, std::istreambuf_iterator<char> {});
+
+        cache.store(2, make_level(2));
+    }
+
+    //as if the process died before the index was written again
+    {
+        std::ofstream out {index, std::ios::trunc};
+        out << flushed;
+    }
+
+    tez::level_cache cache {CACHE_DIR};
+    ASSERT_EQ(2, cache.size());
+
+    auto result = empty_level();
+    ASSERT_TRUE(cache.load(2, result));
+    ASSERT_TRUE(test::same_tiles(make_level(2).grid_, result.grid_));
+
+    //and it counts against max_bytes again
+    ASSERT_LT(0u, cache.bytes());
+    cache.clear();
+    ASSERT_EQ(0u, cache.bytes());
+}
+
+TEST_F(LevelCache, LoadDuringStoreKeepsLevel) {
+    tez::level_cache cache {CACHE_DIR};
+    cache.clear();
+
+    auto const expected = make_level(4);
+    cache.store(4, expected);
+
+    std::atomic<bool> done {false};
+
+    auto writer = std::async(std::launch::async, [&] {
+        for (int i = 0; i < 100; ++i) {
+            cache.store(4, expected);
+        }
+        done = true;
+    });
+
+    //the file is replaced in one step, so every read finds a level
+    size_t loads = 0;
+    while (!done || loads == 0) {
+        auto result = empty_level();
+        ASSERT_TRUE(cache.load(4, result));
+        ++loads;
+    }
+
+    writer.get();
+
+    ASSERT_EQ(1, cache.size());
+    ASSERT_EQ(0, cache.misses());
+}
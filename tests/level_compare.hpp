@@ -0,0 +1,42 @@
+#pragma once
+
+#include "level.hpp"
+
+//==============================================================================
+//! Comparisons of generated levels for tests; tiles and rooms have no
+//! operator==.
+//==============================================================================
+namespace test {
+
+//! same rooms, each with the same rects (and holes) in the same order.
+inline bool same_rooms(std::vector<room_rect_set> const& a, std::vector<room_rect_set> const& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+
+    auto const same_rect = [](room_rect_set::value_t const& x, room_rect_set::value_t const& y) {
+        return x.base == y.base && x.has_hole == y.has_hole
+            && (!x.has_hole || x.hole == y.hole);
+    };
+
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].size() != b[i].size()
+         || !std::equal(a[i].begin(), a[i].end(), b[i].begin(), same_rect)
+        ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//! same size, and the same type, sub type and room of every tile.
+inline bool same_tiles(tile_grid const& a, tile_grid const& b) {
+    return a.width() == b.width() && a.height() == b.height()
+        && std::equal(std::begin(a.tiles_), std::end(a.tiles_), std::begin(b.tiles_)
+             , [](tile_data const& x, tile_data const& y) {
+                 return x.type == y.type && x.sub_type == y.sub_type && x.room_id == y.room_id;
+             });
+}
+
+} //namespace test
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include "level_prefetcher.hpp"
+
+#include "level_compare.hpp"
+
+namespace {
+
+uint64_t const WORLD_SEED = 1984;
+
+level on_demand(int const depth) {
+    auto random = tez::make_stream(WORLD_SEED, static_cast<uint64_t>(depth));
+    return level {random, level::params_t {}};
+}
+
+//! wait, for at most a few seconds, until @p prefetcher holds @p n slots.
+bool wait_for_size(tez::level_prefetcher const& prefetcher, size_t const n) {
+    auto const until = std::chrono::steady_clock::now() + std::chrono::seconds {10};
+
+    while (prefetcher.size() != n) {
+        if (std::chrono::steady_clock::now() > until) {
+            return false;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds {1});
+    }
+
+    return true;
+}
+
+} //namespace
+
+TEST(LevelPrefetcher, TakeMatchesOnDemand) {
+    tez::level_prefetcher prefetcher {WORLD_SEED};
+
+    for (int const depth : {0, 1, 2}) {
+        ASSERT_TRUE(prefetcher.prefetch(depth));
+    }
+
+    for (int const depth : {0, 1, 2}) {
+        auto const expected = on_demand(depth);
+        auto const result   = prefetcher.take(depth);
+
+        ASSERT_TRUE(test::same_tiles(expected.grid_, result.grid_)) << "depth " << depth;
+        ASSERT_TRUE(test::same_tiles(expected.grid_, prefetcher.generate(depth).grid_));
+    }
+
+    ASSERT_EQ(0u, prefetcher.size());
+}
+
+TEST(LevelPrefetcher, RetainCancelsQueued) {
+    //one worker, so at most one level is in progress and the rest are queued
+    tez::level_prefetcher prefetcher {WORLD_SEED, level::params_t {}, 8, 1};
+
+    for (int const depth : {1, 2, 3, 4, 5, 6}) {
+        ASSERT_TRUE(prefetcher.prefetch(depth));
+    }
+
+    prefetcher.retain({6});
+
+    //queued levels go immediately; one in progress may remain until it ends
+    ASSERT_GE(2u, prefetcher.size());
+    ASSERT_TRUE(wait_for_size(prefetcher, 1));
+
+    //the retained level is still there, and a cancelled one is made on demand
+    ASSERT_FALSE(prefetcher.prefetch(6));
+    ASSERT_TRUE(test::same_tiles(on_demand(6).grid_, prefetcher.take(6).grid_));
+    ASSERT_TRUE(test::same_tiles(on_demand(3).grid_, prefetcher.take(3).grid_));
+
+    prefetcher.retain({});
+    ASSERT_TRUE(wait_for_size(prefetcher, 0));
+}
+
+TEST(LevelPrefetcher, RespectsCapacity) {
+    tez::level_prefetcher prefetcher {WORLD_SEED, level::params_t {}, 2, 1};
+
+    ASSERT_TRUE(prefetcher.prefetch(1));
+    ASSERT_FALSE(prefetcher.prefetch(1));
+    ASSERT_TRUE(prefetcher.prefetch(2));
+    ASSERT_FALSE(prefetcher.prefetch(3));
+    ASSERT_GE(2u, prefetcher.size());
+
+    prefetcher.take(1);
+    ASSERT_EQ(1u, prefetcher.size());
+
+    ASSERT_TRUE(prefetcher.prefetch(3));
+    ASSERT_FALSE(prefetcher.prefetch(4));
+    ASSERT_EQ(2u, prefetcher.size());
+}
+
+TEST(LevelPrefetcher, TakeUnprefetchedGeneratesInline) {
+    tez::level_prefetcher prefetcher {WORLD_SEED};
+
+    auto const result = prefetcher.take(7);
+
+    ASSERT_EQ(0u, prefetcher.size());
+    ASSERT_TRUE(test::same_tiles(on_demand(7).grid_, result.grid_));
+}
+
+TEST(LevelPrefetcher, TakeRethrowsFailedGeneration) {
+    //a field too large to allocate
+    level::params_t params;
+    params.field_w = -1;
+    params.field_h = 1;
+
+    tez::level_prefetcher prefetcher {WORLD_SEED, params, 2, 1};
+
+    ASSERT_TRUE(prefetcher.prefetch(1));
+    ASSERT_TRUE(prefetcher.prefetch(2));
+
+    //give the worker time to fail; a level still queued fails in take instead
+    std::this_thread::sleep_for(std::chrono::milliseconds {100});
+
+    ASSERT_THROW(prefetcher.take(1), std::exception);
+    ASSERT_THROW(prefetcher.take(2), std::exception);
+    ASSERT_EQ(0u, prefetcher.size());
+
+    //the worker is still there
+    ASSERT_TRUE(prefetcher.prefetch(3));
+    ASSERT_THROW(prefetcher.take(3), std::exception);
+}
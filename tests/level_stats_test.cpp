@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include "level_stats.hpp"
+
+namespace {
+
+using rect_t    = room_rect_set::rect_t;
+using tile_type = tile_data::tile_type;
+
+//! a level from rows of ' ' (empty), '.' (floor) and '#' (corridor).
+level make_level(std::vector<std::string> const& rows, std::vector<room_rect_set> rooms) {
+    tile_grid grid {rows[0].size(), rows.size()};
+
+    for (size_t y = 0; y < rows.size(); ++y) {
+        for (size_t x = 0; x < rows[y].size(); ++x) {
+            auto& tile = grid.at(x, y);
+            switch (rows[y][x]) {
+            case '.' : tile.type = tile_type::floor;    break;
+            case '#' : tile.type = tile_type::corridor; break;
+            }
+        }
+    }
+
+    return level {level::params_t {}, std::move(rooms), std::move(grid)};
+}
+
+} //namespace
+
+TEST(LevelStats, Counts) {
+    std::vector<room_rect_set> rooms;
+    rooms.emplace_back(rect_t {0, 0, 3, 3});
+    rooms.emplace_back(rect_t {7, 0, 10, 2});
+    rooms.emplace_back(rect_t {8, 1, 10, 3}); //overlaps the room before it
+    rooms.emplace_back(rect_t {0, 5, 2, 6});
+
+    auto const lvl = make_level({
+        "...    ...",
+        "...####...",
+        "...    #..",
+        "       #  ",
+        "          ",
+        "..        ",
+    }, std::move(rooms));
+
+    auto const stats = tez::analyze(lvl);
+
+    ASSERT_EQ(60, stats.tiles);
+    ASSERT_EQ(9 + 6 + 2 + 2, stats.floor_tiles);
+    ASSERT_EQ(6, stats.corridor_tiles);
+    ASSERT_EQ(1, stats.dead_ends);
+    ASSERT_EQ(4, stats.room_count);
+    ASSERT_EQ(1, stats.overlapping_rooms);
+    ASSERT_EQ(2, stats.min_room_area);
+
+    ASSERT_EQ(2, stats.component_sizes.size());
+    ASSERT_EQ(23, stats.component_sizes[0]);
+    ASSERT_EQ(2,  stats.component_sizes[1]);
+    ASSERT_FALSE(stats.is_connected());
+
+    tez::level_limits limits;
+    limits.min_room_area = 3;
+    limits.max_overlapping_rooms = 0;
+
+    ASSERT_EQ(
+        tez::LEVEL_TINY_ROOM | tez::LEVEL_DISCONNECTED | tez::LEVEL_OVERLAPPING_ROOMS
+      , tez::find_defects(stats, limits)
+    );
+}
+
+TEST(LevelStats, GeneratedLevelsPass) {
+    for (uint32_t const seed : {1, 10, 1984, 150123}) {
+        tez::random_t random {seed};
+        level const lvl {random};
+
+        auto const stats = tez::analyze(lvl);
+
+        ASSERT_TRUE(stats.is_connected()) << "seed " << seed;
+        ASSERT_LT(0u, stats.corridor_tiles);
+        ASSERT_EQ(tez::LEVEL_OK, tez::find_defects(stats)) << "seed " << seed;
+    }
+}
+
+TEST(LevelStats, GenerateValidRejects) {
+    tez::level_limits limits;
+    limits.min_rooms = 1000; //nothing passes
+
+    size_t   calls   = 0;
+    uint32_t defects = tez::LEVEL_OK;
+
+    tez::generate_valid([&](size_t const attempt) {
+        EXPECT_EQ(calls++, attempt);
+        auto random = tez::make_stream(10, attempt);
+        return level {random};
+    }, limits, 3, &defects);
+
+    ASSERT_EQ(3, calls);
+    ASSERT_EQ(tez::LEVEL_TOO_FEW_ROOMS, defects);
+
+    calls = 0;
+    tez::generate_valid([&](size_t const attempt) {
+        ++calls;
+        auto random = tez::make_stream(10, attempt);
+        return level {random};
+    }, tez::level_limits {}, 3, &defects);
+
+    ASSERT_EQ(1, calls);
+    ASSERT_EQ(tez::LEVEL_OK, defects);
+}
+
+TEST(LevelStats, AnyIntersectingPairMatchesBruteForce) {
+    tez::random_t random {42};
+    std::uniform_int_distribution<int> pos {0, 200};
+    std::uniform_int_distribution<int> size {1, 12};
+
+    for (int n = 0; n < 200; ++n) {
+        std::vector<rect_t> rects;
+        for (int i = 0; i < 20; ++i) {
+            auto const x = pos(random);
+            auto const y = pos(random);
+            rects.push_back(rect_t {x, y, x + size(random), y + size(random)});
+        }
+
+        bool expected = false;
+        for (size_t i = 0; i < rects.size(); ++i) {
+            for (size_t j = i + 1; j < rects.size(); ++j) {
+                expected = expected || bklib::intersects(rects[i], rects[j]);
+            }
+        }
+
+        ASSERT_EQ(expected, bklib::any_intersecting_pair(rects));
+    }
+}
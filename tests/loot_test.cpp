@@ -4,10 +4,36 @@
 #include <boost/iterator/transform_iterator.hpp>
 
 #include "loot_table.hpp"
+#include "loot_program.hpp"
+#include "loot_analysis.hpp"
+#include "loot_simulator.hpp"
 #include "item.hpp"
 
 #include <bklib/math.hpp>
 
+namespace {
+
+tez::loot_table_table::container_t parse_tables(char const* const text) {
+    tez::loot_table_parser parser {std::istringstream {text}};
+    parser.parse();
+    return parser.get();
+}
+
+tez::loot_table const& table_at(tez::loot_table_table::container_t const& tables, char const* const id) {
+    auto const where = tables.find(tez::loot_table_ref {bklib::utf8string_hash(id)});
+    BK_ASSERT(where != tables.end());
+    return where->second;
+}
+
+char const LINKED_TABLES[] = R"({ "tables": [
+    {"id": "food",   "table": [[1, "item", "apple"], [1, "item", "cheese", ["fixed", 2]]]},
+    {"id": "weapon", "table": [[1, "item", "dagger"]]},
+    {"id": "common", "table": [[1, "table", "weapon"], [1, "table", "food"]]},
+    {"id": "orc",    "table": [[1, "table", "common", ["fixed", 3]]]}
+]})";
+
+} //namespace
+
 template <typename T>
 class grid_block {
 public:
@@ -238,3 +264,548 @@ TEST(LootTable, Basic) {
     //    }
     //}
 }
+
+TEST(LootTable, AliasTableMatchesWeights) {
+    std::vector<double> const weights {10, 20, 30, 5, 0, 35};
+
+    tez::alias_table const table {weights};
+    ASSERT_EQ(weights.size(), table.size());
+
+    tez::random_t random {1984};
+
+    size_t const n = 1000000;
+    std::vector<size_t> counts(weights.size());
+
+    for (size_t i = 0; i < n; ++i) {
+        auto const j = table(random);
+        ASSERT_LT(j, weights.size());
+        ++counts[j];
+    }
+
+    ASSERT_EQ(0, counts[4]);
+
+    for (size_t i = 0; i < weights.size(); ++i) {
+        auto const expected = weights[i] / 100.0;
+        ASSERT_NEAR(expected, static_cast<double>(counts[i]) / n, 0.005);
+    }
+}
+
+TEST(LootTable, AliasTableRejectsEmpty) {
+    std::vector<tez::alias_table::slot_t> slots;
+
+    ASSERT_FALSE(tez::alias_table::build(std::vector<double> {}, slots));
+    ASSERT_FALSE(tez::alias_table::build(std::vector<double> {0, 0}, slots));
+    ASSERT_TRUE(slots.empty());
+
+    ASSERT_TRUE(tez::alias_table::build(std::vector<int> {0, 3}, slots));
+    ASSERT_EQ(2, slots.size());
+}
+
+TEST(LootTable, LinkResolvesReferences) {
+    auto tables = parse_tables(LINKED_TABLES);
+    ASSERT_EQ(4, tables.size());
+
+    auto const errors = tez::link_loot_tables(tables);
+    ASSERT_TRUE(errors.empty());
+
+    auto const& common = table_at(tables, "common");
+    ASSERT_EQ(&table_at(tables, "weapon"), common.entries()[0].table);
+    ASSERT_EQ(&table_at(tables, "food"),   common.entries()[1].table);
+    ASSERT_EQ(&common, table_at(tables, "orc").entries()[0].table);
+
+    ASSERT_EQ(nullptr, table_at(tables, "food").entries()[0].table);
+
+    tez::random_t random {1984};
+    for (int i = 0; i < 100; ++i) {
+        auto const items = table_at(tables, "orc").roll(random);
+        ASSERT_GE(items.size(), 3);
+        ASSERT_LE(items.size(), 6);
+    }
+}
+
+TEST(LootTable, LinkReportsCyclesAndDanglingReferences) {
+    auto tables = parse_tables(R"({ "tables": [
+        {"id": "a", "table": [[1, "table", "b"]]},
+        {"id": "b", "table": [[1, "table", "a"], [1, "item", "apple"]]},
+        {"id": "c", "table": [[1, "table", "missing"]]},
+        {"id": "d", "table": [[1, "table", "d"]]}
+    ]})");
+
+    auto const errors = tez::link_loot_tables(tables);
+    ASSERT_EQ(3, errors.size());
+
+    using kind = tez::loot_link_error::kind;
+
+    auto const count = [&](kind const k) {
+        return std::count_if(std::begin(errors), std::end(errors), [&](tez::loot_link_error const& e) {
+            return e.type == k;
+        });
+    };
+
+    ASSERT_EQ(2, count(kind::cycle));
+    ASSERT_EQ(1, count(kind::dangling_table));
+
+    //what is left is a DAG; rolling terminates.
+    tez::random_t random {1984};
+    for (auto const id : {"a", "b", "c", "d"}) {
+        for (int i = 0; i < 100; ++i) {
+            auto const items = table_at(tables, id).roll(random);
+            ASSERT_LE(items.size(), 1);
+        }
+    }
+}
+
+TEST(LootTable, ProgramMatchesRecursiveRoll) {
+    auto tables = parse_tables(R"({ "tables": [
+        {"id": "food",   "table": [[3, "item", "apple"], [1, "item", "cheese", ["normal", 2, 1]]]},
+        {"id": "weapon", "table": [[1, "item", "dagger"], [2, "item", "sword"], [1, "table", "missing"]]},
+        {"id": "common", "table": [[1, "table", "weapon"], [1, "table", "food", ["fixed", 2]]]},
+        {"id": "orc",    "table": [[1, "table", "common", ["normal", 3, 2]], [1, "item", "tooth"]]}
+    ]})");
+
+    ASSERT_EQ(1, tez::link_loot_tables(tables).size());
+
+    tez::loot_program const program {tables};
+    ASSERT_EQ(4, program.table_count());
+    ASSERT_EQ(9, program.instruction_count());
+    ASSERT_EQ(tez::loot_program::NO_TABLE, program.find("missing"));
+
+    for (auto const id : {"food", "weapon", "common", "orc"}) {
+        auto const& table = table_at(tables, id);
+        auto const  index = program.find(id);
+        ASSERT_NE(tez::loot_program::NO_TABLE, index);
+
+        tez::random_t a {1984};
+        tez::random_t b {1984};
+
+        tez::loot_program::item_list  items;
+        tez::loot_program::stack_t    stack;
+        tez::loot_table::history_t    history;
+        tez::loot_table::item_list    expected;
+
+        for (int i = 0; i < 1000; ++i) {
+            items.clear();
+            expected.clear();
+
+            table.roll(a, expected, history);
+            program.roll(index, b, items, stack);
+
+            ASSERT_EQ(expected.size(), items.size());
+            ASSERT_TRUE(std::equal(std::begin(items), std::end(items), std::begin(expected)));
+        }
+    }
+}
+
+TEST(LootTable, DistributionKinds) {
+    using tez::distribution;
+
+    tez::random_t random {1984};
+
+    auto const mean_of = [&](distribution const& d, int const lo, int const hi) {
+        double sum = 0.0;
+        for (int i = 0; i < 100000; ++i) {
+            auto const x = d(random);
+            EXPECT_LE(lo, x);
+            EXPECT_GE(hi, x);
+            sum += x;
+        }
+        return sum / 100000;
+    };
+
+    ASSERT_EQ(7, distribution::make_fixed(7)(random));
+    ASSERT_EQ(0, distribution {}(random));
+
+    ASSERT_NEAR(3.0,  mean_of(distribution::make_uniform_int(1, 5), 1, 5), 0.05);
+    ASSERT_NEAR(-1.0, mean_of(distribution::make_uniform_int(-3, 1), -3, 1), 0.05);
+    ASSERT_NEAR(10.0, mean_of(distribution::make_normal(10, 2), -100, 100), 0.05);
+    ASSERT_NEAR(1.0,  mean_of(distribution::make_binomial(4, 0.25), 0, 4), 0.02);
+    ASSERT_NEAR(2.5,  mean_of(distribution::make_poisson(2.5), 0, 100), 0.05);
+
+    //the full range of int32_t
+    auto const all = distribution::make_uniform_int(
+        std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max()
+    );
+    all(random);
+}
+
+TEST(LootTable, ParsesDistributions) {
+    auto tables = parse_tables(R"({ "tables": [
+        {"id": "a", "table": [[1, "item", "x", ["uniform", 2, 4]]]},
+        {"id": "b", "table": [[1, "item", "x", ["binomial", 3, 50]]]},
+        {"id": "c", "table": [[1, "item", "x", ["poisson", 2]]]},
+        {"id": "d", "table": [[1, "item", "x"]]}
+    ]})");
+
+    using kind = tez::distribution::kind;
+
+    auto const count_of = [&](char const* const id) {
+        return table_at(tables, id).entries()[0].count;
+    };
+
+    ASSERT_EQ(kind::uniform, count_of("a").type());
+    ASSERT_EQ(2, count_of("a").uniform().min);
+    ASSERT_EQ(4, count_of("a").uniform().max);
+
+    ASSERT_EQ(kind::binomial, count_of("b").type());
+    ASSERT_EQ(3, count_of("b").binomial().trials);
+    ASSERT_FLOAT_EQ(0.5f, count_of("b").binomial().p);
+
+    ASSERT_EQ(kind::poisson, count_of("c").type());
+    ASSERT_FLOAT_EQ(2.0f, count_of("c").poisson().mean);
+
+    ASSERT_EQ(kind::fixed, count_of("d").type());
+    ASSERT_EQ(1, count_of("d").fixed());
+}
+
+TEST(LootTable, BatchRollsMatchSingleRolls) {
+    auto tables = parse_tables(LINKED_TABLES);
+    ASSERT_TRUE(tez::link_loot_tables(tables).empty());
+
+    tez::loot_program const program {tables};
+
+    auto const orc    = program.find("orc");
+    auto const food   = program.find("food");
+    auto const common = program.find("common");
+
+    tez::loot_batch batch;
+
+    //the same table many times
+    tez::random_t a {1984};
+    tez::random_t b {1984};
+
+    program.roll(orc, 500, a, batch);
+    ASSERT_EQ(500, batch.size());
+
+    tez::loot_program::item_list items;
+    tez::loot_program::stack_t   stack;
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+        items.clear();
+        program.roll(orc, b, items, stack);
+
+        tez::loot_program::item_list expanded;
+        for (auto it = batch.begin(i); it != batch.end(i); ++it) {
+            ASSERT_LT(0, it->count);
+            if (it != batch.begin(i)) {
+                ASSERT_NE(it[-1].item, it->item); //runs are joined
+            }
+
+            expanded.insert(std::end(expanded), it->count, it->item);
+        }
+
+        ASSERT_TRUE(items == expanded);
+    }
+
+    //many different tables
+    batch.clear();
+    ASSERT_EQ(0, batch.size());
+
+    uint32_t const ids[] = {food, common, orc, food};
+    program.roll(ids, 4, a, batch);
+    ASSERT_EQ(4, batch.size());
+
+    //a roll of food is a single drop of 1 apple or 2 cheese
+    ASSERT_EQ(1, batch.end(0) - batch.begin(0));
+    ASSERT_EQ(1, batch.end(3) - batch.begin(3));
+}
+
+TEST(LootTable, CountProbabilities) {
+    using tez::distribution;
+
+    auto const check = [](distribution const& d, double const expected) {
+        auto const p = tez::count_probabilities(d);
+
+        double total = 0.0;
+        double mean  = 0.0;
+        for (size_t k = 0; k < p.size(); ++k) {
+            total += p[k];
+            mean  += k * p[k];
+        }
+
+        EXPECT_NEAR(1.0, total, 1e-9);
+        EXPECT_NEAR(expected, mean, 1e-6);
+    };
+
+    check(distribution::make_fixed(3), 3.0);
+    check(distribution::make_fixed(-2), 0.0);
+    check(distribution::make_uniform_int(1, 5), 3.0);
+    check(distribution::make_uniform_int(-2, 2), (1.0 + 2.0) / 5.0);
+    check(distribution::make_normal(20, 3), 20.0);
+    check(distribution::make_binomial(10, 0.25), 2.5);
+    check(distribution::make_poisson(4), 4.0);
+}
+
+TEST(LootTable, AnalysisIsExact) {
+    auto tables = parse_tables(LINKED_TABLES);
+    ASSERT_TRUE(tez::link_loot_tables(tables).empty());
+
+    tez::loot_analyzer analyze;
+
+    auto const item = [](char const* const id) {
+        return tez::item_ref {bklib::utf8string_hash(id)};
+    };
+
+    auto const& orc = table_at(tables, "orc");
+    ASSERT_EQ(3, analyze(orc).size());
+
+    auto const dagger = analyze.rate(orc, item("dagger"));
+    ASSERT_NEAR(1.5,   dagger.expected,    1e-9);
+    ASSERT_NEAR(0.875, dagger.probability, 1e-9);
+
+    auto const apple = analyze.rate(orc, item("apple"));
+    ASSERT_NEAR(0.75,     apple.expected,    1e-9);
+    ASSERT_NEAR(0.578125, apple.probability, 1e-9);
+
+    auto const cheese = analyze.rate(orc, item("cheese"));
+    ASSERT_NEAR(1.5,      cheese.expected,    1e-9);
+    ASSERT_NEAR(0.578125, cheese.probability, 1e-9);
+
+    ASSERT_EQ(0.0, analyze.rate(orc, item("tooth")).probability);
+}
+
+TEST(LootTable, AnalysisMatchesSimulation) {
+    auto tables = parse_tables(R"({ "tables": [
+        {"id": "food",  "table": [[3, "item", "apple", ["uniform", 0, 2]], [1, "item", "cheese", ["normal", 1, 1]]]},
+        {"id": "gem",   "table": [[9, "item", "dust"], [1, "item", "ruby", ["binomial", 3, 40]]]},
+        {"id": "chest", "table": [[2, "table", "food", ["poisson", 2]], [1, "table", "gem", ["uniform", 1, 3]], [1, "item", "apple"]]}
+    ]})");
+
+    ASSERT_TRUE(tez::link_loot_tables(tables).empty());
+
+    auto const& chest = table_at(tables, "chest");
+
+    tez::loot_analyzer analyze;
+    auto const& rates = analyze(chest);
+    ASSERT_EQ(4, rates.size());
+
+    size_t const n = 200000;
+
+    std::map<tez::hash_t, double> counts;
+    std::map<tez::hash_t, double> drops;
+
+    tez::random_t random {1984};
+    tez::loot_table::item_list items;
+    tez::loot_table::history_t history;
+
+    for (size_t i = 0; i < n; ++i) {
+        items.clear();
+        chest.roll(random, items, history);
+
+        std::sort(std::begin(items), std::end(items));
+        for (size_t j = 0; j < items.size(); ++j) {
+            counts[items[j].value] += 1;
+            if (j == 0 || items[j - 1] != items[j]) {
+                drops[items[j].value] += 1;
+            }
+        }
+    }
+
+    for (auto const& r : rates) {
+        EXPECT_NEAR(r.expected,    counts[r.item.value] / n, 0.01 + 0.01 * r.expected);
+        EXPECT_NEAR(r.probability, drops[r.item.value]  / n, 0.005);
+    }
+}
+
+TEST(LootTable, SimulationIsIndependentOfThreadCount) {
+    auto tables = parse_tables(LINKED_TABLES);
+    ASSERT_TRUE(tez::link_loot_tables(tables).empty());
+
+    auto const& orc = table_at(tables, "orc");
+
+    //not a multiple of the chunk size
+    uint64_t const rolls = 50000;
+
+    auto const expected = tez::simulate_loot(orc, rolls, 42, 1);
+    ASSERT_EQ(rolls, expected.rolls);
+    ASSERT_EQ(3, expected.items.size());
+
+    for (unsigned const threads : {2u, 3u, 8u, 0u}) {
+        ASSERT_TRUE(expected == tez::simulate_loot(orc, rolls, 42, threads));
+    }
+
+    ASSERT_FALSE(expected == tez::simulate_loot(orc, rolls, 43, 1));
+
+    for (auto const& value : expected.items) {
+        ASSERT_EQ(rolls, std::accumulate(std::begin(value.histogram), std::end(value.histogram), uint64_t {0}));
+    }
+
+    //and agrees with the exact rates
+    tez::loot_analyzer analyze;
+    for (auto const& rate : analyze(orc)) {
+        EXPECT_NEAR(rate.expected,    expected.expected(rate.item),    0.02);
+        EXPECT_NEAR(rate.probability, expected.probability(rate.item), 0.01);
+    }
+}
+
+TEST(LootTable, TablesReloadWhileRead) {
+    using table = tez::loot_table_table;
+
+    {
+        std::istringstream in {LINKED_TABLES};
+        table::reload(in);
+    }
+
+    ASSERT_TRUE(table::is_loaded());
+
+    auto const first = table::snapshot();
+    auto const orc   = table::get("orc");
+    ASSERT_NE(nullptr, orc);
+    ASSERT_EQ(orc, table::get(first, "orc"));
+
+    std::atomic<bool>   done  {false};
+    std::atomic<size_t> rolls {0};
+
+    auto const read = [&](uint32_t const seed) {
+        tez::random_t random {seed};
+
+        while (!done) {
+            auto const tables = table::snapshot();
+            auto const loot   = table::get(tables, "orc");
+            EXPECT_NE(nullptr, loot);
+
+            auto const items = loot->roll(random);
+            EXPECT_LE(3, items.size());
+            EXPECT_GE(6, items.size());
+
+            ++rolls;
+        }
+    };
+
+    std::vector<std::future<void>> readers;
+    for (uint32_t i = 0; i < 3; ++i) {
+        readers.emplace_back(std::async(std::launch::async, read, i));
+    }
+
+    for (int i = 0; i < 50; ++i) {
+        std::istringstream in {LINKED_TABLES};
+        table::reload(in);
+        table::reclaim();
+    }
+
+    done = true;
+    for (auto& reader : readers) {
+        reader.get();
+    }
+
+    ASSERT_NE(first, table::snapshot());
+    ASSERT_NE(orc, table::get("orc"));
+
+    //still alive; held by first
+    ASSERT_EQ(orc, table::get(first, "orc"));
+    ASSERT_EQ(tez::string_ref {"orc"}, orc->id());
+}
+
+TEST(LootTable, RelinkPublishesLinkedCopy) {
+    using table = tez::loot_table_table;
+
+    {
+        std::istringstream in {LINKED_TABLES};
+        table::reload(in);
+    }
+
+    auto const first = table::snapshot();
+    ASSERT_TRUE(tez::relink_loot_tables());
+    ASSERT_NE(first, table::snapshot());
+
+    //linked into the new snapshot, not the old one
+    auto const orc = table::get("orc");
+    ASSERT_NE(nullptr, orc);
+
+    auto const common = orc->entries()[0].table;
+    ASSERT_EQ(table::get("common"), common);
+    ASSERT_NE(table::get(first, "common"), common);
+
+    tez::random_t random {3};
+    auto const items = orc->roll(random);
+    ASSERT_LE(3, items.size());
+    ASSERT_GE(6, items.size());
+
+    table::unload();
+    ASSERT_FALSE(tez::relink_loot_tables());
+    ASSERT_FALSE(table::is_loaded());
+}
+
+TEST(LootTable, HeldEntriesSurviveReclaim) {
+    using table = tez::loot_table_table;
+
+    {
+        std::istringstream in {LINKED_TABLES};
+        table::reload(in);
+    }
+
+    ASSERT_FALSE(table::hold("no such table"));
+
+    auto const expected = tez::simulate_loot(*table::hold("orc"), 10000, 5, 1);
+
+    //simulated off this thread while this thread reloads and reclaims
+    auto simulated = std::async(std::launch::async, [] {
+        std::vector<tez::loot_simulation> result;
+        for (int i = 0; i < 20; ++i) {
+            result.push_back(tez::simulate_loot(*table::hold("orc"), 10000, 5, 2));
+        }
+        return result;
+    });
+
+    auto const held = table::hold("orc");
+
+    for (int i = 0; i < 50; ++i) {
+        std::istringstream in {LINKED_TABLES};
+        table::reload(in);
+        table::reclaim();
+    }
+
+    for (auto const& result : simulated.get()) {
+        ASSERT_TRUE(expected == result);
+    }
+
+    ASSERT_NE(held.snapshot(), table::snapshot());
+    ASSERT_EQ(held.get(), table::get(held.snapshot(), "orc"));
+    ASSERT_EQ(tez::string_ref {"orc"}, held->id());
+}
+
+TEST(LootTable, FailedReloadKeepsTables) {
+    using table = tez::loot_table_table;
+
+    {
+        std::istringstream in {LINKED_TABLES};
+        ASSERT_TRUE(table::try_reload(in));
+    }
+
+    auto const before = table::snapshot();
+
+    {
+        //not json
+        std::istringstream in {R"({"tables": [)"};
+        ASSERT_FALSE(table::try_reload(in));
+    }
+
+    {
+        //json, but not loot tables
+        std::istringstream in {R"({"tables": 3})"};
+        ASSERT_FALSE(table::try_reload(in));
+    }
+
+    ASSERT_FALSE(table::try_reload("./no_such_file.def"));
+
+    //loot tables, but not valid ones
+    char const* const invalid[] = {
+        R"({"tables": [{"id": "t", "table": [[1, "monster", "orc"]]}]})"
+      , R"({"tables": [{"id": "t", "table": [[1, "item", "a", ["gaussian", 1, 2]]]}]})"
+      , R"({"tables": [{"id": "t", "table": [[1, "item", "a", ["binomial", -1, 50]]]}]})"
+      , R"({"tables": [{"id": "t", "table": [[1, "item", "a", ["binomial", 3, 150]]]}]})"
+      , R"({"tables": [{"id": "t", "table": [[1, "item", "a", ["normal", 3, -1]]]}]})"
+      , R"({"tables": [{"id": "t", "table": [[1, "item", "a", ["poisson", -2]]]}]})"
+      , R"({"tables": [{"id": "t", "table": [[1, "item", "a", ["uniform", 4, 1]]]}]})"
+      , R"({"tables": [{"id": "t", "table": [[-1, "item", "a"], [2, "item", "b"]]}]})"
+      , R"({"tables": [{"id": "t", "table": [[0, "item", "a"], [0, "item", "b"]]}]})"
+      , R"({"tables": [{"id": "t", "table": []}]})"
+    };
+
+    for (auto const json : invalid) {
+        std::istringstream in {json};
+        ASSERT_FALSE(table::try_reload(in)) << json;
+    }
+
+    ASSERT_EQ(before, table::snapshot());
+    ASSERT_NE(nullptr, table::get("orc"));
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include "prefab.hpp"
+#include "room.hpp"
+
+namespace {
+
+using tez::orientation;
+using tez::tile_type;
+
+//! the tile types of @p grid as one string per row.
+std::vector<std::string> to_rows(tez::grid2d<tez::tile_data> const& grid) {
+    std::vector<std::string> result;
+
+    for (size_t y = 0; y < grid.height(); ++y) {
+        std::string row;
+        for (size_t x = 0; x < grid.width(); ++x) {
+            row.push_back(tez::as_char(grid.row(y)[x].type));
+        }
+        result.push_back(row);
+    }
+
+    return result;
+}
+
+
+} //namespace
+
+TEST(Prefab, Orientations) {
+    //#..
+    //...
+    tez::prefab::grid_t corner {3, 2, tez::tile_data {tile_type::floor}};
+    corner.row(0)[0].type = tile_type::wall;
+
+    tez::prefab const p {corner};
+
+    using rows = std::vector<std::string>;
+
+    ASSERT_EQ((rows {"#..", "..."}),      to_rows(p.get(orientation::r0)));
+    ASSERT_EQ((rows {".#", "..", ".."}),  to_rows(p.get(orientation::r90)));
+    ASSERT_EQ((rows {"...", "..#"}),      to_rows(p.get(orientation::r180)));
+    ASSERT_EQ((rows {"..", "..", "#."}),  to_rows(p.get(orientation::r270)));
+    ASSERT_EQ((rows {"..#", "..."}),      to_rows(p.get(orientation::mirror_r0)));
+    ASSERT_EQ((rows {"..", "..", ".#"}),  to_rows(p.get(orientation::mirror_r90)));
+    ASSERT_EQ((rows {"...", "#.."}),      to_rows(p.get(orientation::mirror_r180)));
+    ASSERT_EQ((rows {"#.", "..", ".."}),  to_rows(p.get(orientation::mirror_r270)));
+}
+
+TEST(Prefab, Stamp) {
+    tez::prefab const p {tez::generator::room_simple_fixed {4, 3}.build()};
+
+    tez::grid2d<tez::tile_data> map {6, 6};
+    p.stamp(map, 1, 2, orientation::r90);
+
+    using rows = std::vector<std::string>;
+    ASSERT_EQ((rows {
+        "      "
+      , "      "
+      , " ###  "
+      , " #.#  "
+      , " #.#  "
+      , " ###  "
+    }), to_rows(map));
+}
+
+TEST(Prefab, FixedRoomsAreStamped) {
+    tez::random rand {7};
+
+    for (unsigned w = 3; w <= 8; ++w) {
+        for (unsigned h = 3; h <= 6; ++h) {
+            tez::generator::room_simple_fixed const gen {w, h};
+
+            //stamped from its prefab, and the same as building it
+            ASSERT_EQ(to_rows(gen.build()), to_rows(gen.generate(rand)));
+            ASSERT_EQ(to_rows(gen.build()), to_rows(gen.generate(rand)));
+        }
+    }
+
+    //room_simple keeps one fixed generator per size it draws
+    tez::generator::room_simple gen {{3u, 5u}, {3u, 5u}};
+    for (int i = 0; i < 100; ++i) {
+        auto const r = gen.generate(rand);
+        auto const w = static_cast<unsigned>(r.width());
+        auto const h = static_cast<unsigned>(r.height());
+
+        ASSERT_EQ(to_rows(tez::generator::room_simple_fixed {w, h}.build()), to_rows(r));
+    }
+    ASSERT_GE(9u, gen.fixed_.size());
+}
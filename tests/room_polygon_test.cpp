@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include "level.hpp"
+
+namespace {
+
+using rect_t = room_rect_set::rect_t;
+
+//! whether (x, y) is inside some base of @p rects and outside every hole.
+bool brute_contains(room_rect_set const& rects, int const x, int const y) {
+    bool solid = false;
+
+    for (auto const& value : rects) {
+        auto const& b = value.base;
+        if (x >= b.left() && x < b.right() && y >= b.top() && y < b.bottom()) {
+            solid = true;
+        }
+    }
+
+    for (auto const& value : rects) {
+        auto const& h = value.hole;
+        if (value.has_hole && x >= h.left() && x < h.right() && y >= h.top() && y < h.bottom()) {
+            return false;
+        }
+    }
+
+    return solid;
+}
+
+} //namespace
+
+TEST(RoomPolygon, Empty) {
+    room_polygon const p;
+
+    ASSERT_TRUE(p.empty());
+    ASSERT_EQ(0, p.area());
+    ASSERT_FALSE(p.contains(0, 0));
+}
+
+TEST(RoomPolygon, RectWithHole) {
+    room_rect_set rects {rect_t {0, 0, 10, 8}};
+    rects.subtract(rects.begin(), rect_t {2, 2, 5, 4});
+
+    room_polygon const p {rects};
+
+    ASSERT_EQ(10*8 - 3*2, p.area());
+    ASSERT_EQ(rect_t(0, 0, 10, 8), p.bounds());
+
+    ASSERT_TRUE(p.contains(1, 2));
+    ASSERT_FALSE(p.contains(2, 2));
+    ASSERT_FALSE(p.contains(4, 3));
+    ASSERT_TRUE(p.contains(5, 3));
+    ASSERT_FALSE(p.contains(10, 0));
+    ASSERT_FALSE(p.contains(0, -1));
+
+    //row 2 is split around the hole
+    auto const row = p.row(2);
+    ASSERT_EQ(2, row.second - row.first);
+    ASSERT_EQ(0, row.first[0].x0); ASSERT_EQ(2,  row.first[0].x1);
+    ASSERT_EQ(5, row.first[1].x0); ASSERT_EQ(10, row.first[1].x1);
+}
+
+TEST(RoomPolygon, MatchesBruteForce) {
+    tez::random_t random {1984};
+
+    auto const roll = [&](int const lo, int const hi) {
+        return std::uniform_int_distribution<int> {lo, hi}(random);
+    };
+
+    for (int n = 0; n < 100; ++n) {
+        room_rect_set rects {rect_t {roll(0, 10), roll(0, 10), roll(14, 24), roll(14, 24)}};
+
+        auto const count = roll(0, 4);
+        for (int i = 0; i < count; ++i) {
+            auto const x = roll(0, 20);
+            auto const y = roll(0, 20);
+            rects.add(rect_t {x, y, x + roll(3, 10), y + roll(3, 10)});
+        }
+
+        //a hole in some of the rects
+        for (auto it = rects.begin(); it != rects.end(); ++it) {
+            auto const& b = it->base;
+            if (roll(0, 1) && b.width() > 2 && b.height() > 2) {
+                rects.subtract(it, rect_t {b.left() + 1, b.top() + 1, b.right() - 1, b.bottom() - 1});
+            }
+        }
+
+        room_polygon const p {rects};
+
+        size_t area = 0;
+        for (int y = -1; y < 36; ++y) {
+            for (int x = -1; x < 36; ++x) {
+                auto const expected = brute_contains(rects, x, y);
+                area += expected ? 1 : 0;
+                ASSERT_EQ(expected, p.contains(x, y)) << x << ", " << y;
+            }
+        }
+
+        ASSERT_EQ(area, p.area());
+
+        size_t spans_area = 0;
+        p.for_each_span([&](int const y, int const x0, int const x1) {
+            ASSERT_LT(x0, x1);
+            spans_area += static_cast<size_t>(x1 - x0);
+        });
+
+        ASSERT_EQ(area, spans_area);
+    }
+}
+
+TEST(RoomPolygon, ArenaBacked) {
+    tez::arena arena;
+
+    room_rect_set rects {rect_t {0, 0, 4, 4}};
+    rects.add(rect_t {2, 2, 8, 8});
+
+    room_polygon const p {rects, tez::arena_allocator<int> {&arena}};
+
+    ASSERT_EQ(16 + 36 - 4, p.area());
+    ASSERT_LT(0u, arena.allocations());
+}
@@ -0,0 +1,80 @@
+//==============================================================================
+//! Compiles the definition files into a data pack; see data_pack.
+//!
+//! The files are parsed and checked exactly as the game would parse them, so
+//! a pack holds the same tables as the files it was made from.
+//!
+//! usage: tez_datapack [options]
+//!   --items PATH   item definitions (default ./data/items.def)
+//!   --loot  PATH   loot definitions (default ./data/loot.def)
+//!   --out   PATH   the pack to write (default ./data/content.pack)
+//==============================================================================
+#include "data_pack.hpp"
+
+namespace {
+
+struct options_t {
+    std::string items = "./data/items.def";
+    std::string loot  = "./data/loot.def";
+    std::string out   = "./data/content.pack";
+};
+
+bool parse_options(int const argc, char const* const argv[], options_t& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string const arg = argv[i];
+
+        if (i + 1 >= argc) {
+            std::cerr << "missing value for " << arg << std::endl;
+            return false;
+        }
+
+        std::string const value = argv[++i];
+
+        if (arg == "--items") {
+            options.items = value;
+        } else if (arg == "--loot") {
+            options.loot = value;
+        } else if (arg == "--out") {
+            options.out = value;
+        } else {
+            std::cerr << "unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} //namespace
+
+int main(int const argc, char const* const argv[]) {
+    options_t options;
+    if (!parse_options(argc, argv, options)) {
+        return 1;
+    }
+
+    //loaded into the tables so the loot tables are linked, and checked,
+    //against the items
+    if (!tez::item_table::try_reload(options.items)
+     || !tez::loot_table_table::try_reload(options.loot)
+    ) {
+        return 1;
+    }
+
+    auto const& items  = tez::item_table::data();
+    auto const& tables = tez::loot_table_table::data();
+
+    std::ofstream out {options.out, std::ios::binary | std::ios::trunc};
+    tez::write_data_pack(out, items, tables);
+
+    if (!out.flush()) {
+        std::cerr << "couldn't write " << options.out << std::endl;
+        return 1;
+    }
+
+    std::cerr << options.out << ": " << items.size() << " items, "
+              << tables.size() << " loot tables, version " << tez::data_pack::VERSION
+              << std::endl;
+
+    return 0;
+}
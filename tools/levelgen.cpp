@@ -0,0 +1,268 @@
+//==============================================================================
+//! Headless batch level generation.
+//!
+//! Generates levels for a range of seeds across a pool of threads, optionally
+//! dumps each map, and reports throughput, latency, peak memory, the time
+//! and allocations of each generation stage, and how many levels fail the
+//! default level_limits.
+//!
+//! usage: tez_levelgen [options]
+//!   --count   N            number of levels to generate (default 100)
+//!   --seed    S            seed of the first level; level i uses S + i (default 10)
+//!   --threads T            worker threads; 0 for one per core (default 0)
+//!   --format  none|ascii|binary   (default none)
+//!   --out     DIR          write one file per level to DIR instead of stdout
+//==============================================================================
+#include "level.hpp"
+#include "level_stats.hpp"
+
+#if BOOST_OS_WINDOWS
+#   include <windows.h>
+#   include <psapi.h>
+#   pragma comment(lib, "psapi.lib")
+#else
+#   include <sys/resource.h>
+#endif
+
+namespace {
+
+enum class output_format {
+    none, ascii, binary
+};
+
+struct options_t {
+    size_t        count   = 100;
+    uint32_t      seed    = 10;
+    unsigned      threads = 0;
+    output_format format  = output_format::none;
+    std::string   out_dir;
+};
+
+//------------------------------------------------------------------------------
+//! Peak resident memory of the process in bytes; 0 if unknown.
+//------------------------------------------------------------------------------
+size_t peak_memory() {
+#if BOOST_OS_WINDOWS
+    PROCESS_MEMORY_COUNTERS counters {};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+
+    return counters.PeakWorkingSetSize;
+#else
+    rusage usage {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+
+    #if BOOST_OS_MACOS
+        return static_cast<size_t>(usage.ru_maxrss);        //bytes
+    #else
+        return static_cast<size_t>(usage.ru_maxrss) * 1024; //kilobytes
+    #endif
+#endif
+}
+
+bool parse_options(int const argc, char const* const argv[], options_t& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string const arg = argv[i];
+
+        if (i + 1 >= argc) {
+            std::cerr << "missing value for " << arg << std::endl;
+            return false;
+        }
+
+        std::string const value = argv[++i];
+
+        if (arg == "--count") {
+            options.count = std::stoul(value);
+        } else if (arg == "--seed") {
+            options.seed = static_cast<uint32_t>(std::stoul(value));
+        } else if (arg == "--threads") {
+            options.threads = static_cast<unsigned>(std::stoul(value));
+        } else if (arg == "--out") {
+            options.out_dir = value;
+        } else if (arg == "--format") {
+            if      (value == "none")   options.format = output_format::none;
+            else if (value == "ascii")  options.format = output_format::ascii;
+            else if (value == "binary") options.format = output_format::binary;
+            else {
+                std::cerr << "unknown format " << value << std::endl;
+                return false;
+            }
+        } else {
+            std::cerr << "unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if (options.format == output_format::binary && options.out_dir.empty()) {
+        std::cerr << "--format binary requires --out" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+void write_ascii(std::ostream& out, level const& lvl) {
+    auto const& grid = lvl.grid_;
+
+    std::string line;
+    line.reserve(grid.width() + 1);
+
+    for (size_t y = 0; y < grid.height(); ++y) {
+        line.clear();
+        for (size_t x = 0; x < grid.width(); ++x) {
+            line.push_back(as_char(grid.at(x, y).type));
+        }
+        line.push_back('\n');
+
+        out << line;
+    }
+}
+
+//------------------------------------------------------------------------------
+//! "TEZL", uint32 width, uint32 height, then width*height raw tile_data.
+//------------------------------------------------------------------------------
+void write_binary(std::ostream& out, level const& lvl) {
+    auto const& grid = lvl.grid_;
+
+    char     const magic[4] = {'T', 'E', 'Z', 'L'};
+    uint32_t const w = static_cast<uint32_t>(grid.width());
+    uint32_t const h = static_cast<uint32_t>(grid.height());
+
+    out.write(magic, sizeof(magic));
+    out.write(reinterpret_cast<char const*>(&w), sizeof(w));
+    out.write(reinterpret_cast<char const*>(&h), sizeof(h));
+    out.write(
+        reinterpret_cast<char const*>(grid.tiles_.data())
+      , grid.tiles_.size() * sizeof(tile_data)
+    );
+}
+
+void write_level(options_t const& options, uint32_t const seed, level const& lvl, std::mutex& out_mutex) {
+    if (options.format == output_format::none) {
+        return;
+    }
+
+    if (options.out_dir.empty()) {
+        std::lock_guard<std::mutex> lock {out_mutex};
+        std::cout << "seed " << seed << "\n";
+        write_ascii(std::cout, lvl);
+        return;
+    }
+
+    auto const binary = options.format == output_format::binary;
+    auto const name   = options.out_dir + "/level_" + std::to_string(seed)
+      + (binary ? ".bin" : ".txt");
+
+    std::ofstream out {name, binary ? std::ios::binary : std::ios::out};
+    if (!out) {
+        std::lock_guard<std::mutex> lock {out_mutex};
+        std::cerr << "failed to open " << name << std::endl;
+        return;
+    }
+
+    if (binary) write_binary(out, lvl);
+    else        write_ascii(out, lvl);
+}
+
+double percentile(std::vector<double> const& sorted, double const p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+
+    auto const i = static_cast<size_t>(std::ceil(p * sorted.size()));
+    return sorted[i ? i - 1 : 0];
+}
+
+} //namespace
+
+int main(int argc, char const* argv[]) {
+    using clock_t = std::chrono::high_resolution_clock;
+    using ms      = std::chrono::duration<double, std::milli>;
+
+    options_t options;
+    if (!parse_options(argc, argv, options)) {
+        return 1;
+    }
+
+    //levels are already generated in parallel; keep each one single threaded.
+    auto params = grid_layout::params_t {};
+    params.thread_count = 1;
+
+    std::vector<double> latency(options.count);
+    std::mutex          out_mutex;
+
+    //levels failing validation, and the time spent validating
+    std::atomic<size_t> defective {0};
+    std::vector<double> analyze_ms(options.count);
+
+    //per stage totals over all levels
+    auto const stage_names = level_pipeline::make_default().stages();
+    std::vector<level_pipeline::stats_t> stage_totals(stage_names.size());
+    std::mutex                           stage_mutex;
+
+    auto const start = clock_t::now();
+
+    tez::parallel_for(options.count, options.threads, [&](size_t const i) {
+        auto const seed = static_cast<uint32_t>(options.seed + i);
+
+        auto const t0 = clock_t::now();
+        tez::random_t random {seed};
+        auto pipeline = level_pipeline::make_default();
+        level lvl {random, params, pipeline};
+        auto const t1 = clock_t::now();
+
+        latency[i] = ms(t1 - t0).count();
+
+        if (tez::find_defects(tez::analyze(lvl)) != tez::LEVEL_OK) {
+            ++defective;
+        }
+
+        analyze_ms[i] = ms(clock_t::now() - t1).count();
+
+        {
+            std::lock_guard<std::mutex> lock {stage_mutex};
+
+            auto const& stages = pipeline.stages();
+            for (size_t j = 0; j < stages.size(); ++j) {
+                stage_totals[j] += stages[j].total;
+            }
+        }
+
+        write_level(options, seed, lvl, out_mutex);
+    });
+
+    auto const total = ms(clock_t::now() - start).count();
+
+    std::sort(std::begin(latency), std::end(latency));
+
+    std::cerr << std::fixed << std::setprecision(3)
+        << "levels:     " << options.count << "\n"
+        << "threads:    " << tez::worker_count(options.threads) << "\n"
+        << "total:      " << total << " ms\n"
+        << "levels/sec: " << (total > 0.0 ? options.count * 1000.0 / total : 0.0) << "\n"
+        << "p50:        " << percentile(latency, 0.50) << " ms\n"
+        << "p99:        " << percentile(latency, 0.99) << " ms\n"
+        << "peak mem:   " << peak_memory() / 1024 << " KiB\n"
+        << "defective:  " << defective << "\n"
+        << "analyze:    " << std::accumulate(std::begin(analyze_ms), std::end(analyze_ms), 0.0)
+                             / (options.count ? options.count : 1) << " ms/level\n"
+        << "stage          total ms    allocs/level   KiB/level   arena allocs/level   arena KiB/level\n";
+
+    auto const n = static_cast<double>(options.count ? options.count : 1);
+
+    for (size_t j = 0; j < stage_totals.size(); ++j) {
+        auto const& t = stage_totals[j];
+
+        std::cerr << std::left  << std::setw(12) << stage_names[j].name
+                  << std::right << std::setw(11) << t.time_ms
+                  << std::setw(16) << t.allocations / n
+                  << std::setw(12) << t.bytes / n / 1024.0
+                  << std::setw(21) << t.arena_allocations / n
+                  << std::setw(18) << t.arena_bytes / n / 1024.0 << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,241 @@
+//==============================================================================
+//! Loot table sampling benchmark.
+//!
+//! Compares entry picks/sec of std::discrete_distribution against the
+//! alias_table used by loot_table, for the weights of every table in a loot
+//! definition file and for a synthetic table, then compares full rolls/sec of
+//! every loaded loot_table against the same table compiled to a loot_program,
+//! rolled one at a time and in batches. Finally times the exact drop rate
+//! analysis, and a parallel simulation, of every loaded table.
+//!
+//! usage: tez_lootbench [options]
+//!   --file    PATH   loot definitions (default ./data/loot.def)
+//!   --picks   N      picks per measurement (default 10000000)
+//!   --entries N      entries in the synthetic table (default 10000)
+//!   --seed    S      (default 10)
+//!   --threads T      simulation threads; 0 for one per core (default 0)
+//==============================================================================
+#include "loot_table.hpp"
+#include "loot_program.hpp"
+#include "loot_analysis.hpp"
+#include "loot_simulator.hpp"
+#include "parallel.hpp"
+
+namespace {
+
+using clock_type = std::chrono::high_resolution_clock;
+using ms         = std::chrono::duration<double, std::milli>;
+
+struct options_t {
+    std::string file    = "./data/loot.def";
+    size_t      picks   = 10000000;
+    size_t      entries = 10000;
+    uint32_t    seed    = 10;
+    unsigned    threads = 0;
+};
+
+bool parse_options(int const argc, char const* const argv[], options_t& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string const arg = argv[i];
+
+        if (i + 1 >= argc) {
+            std::cerr << "missing value for " << arg << std::endl;
+            return false;
+        }
+
+        std::string const value = argv[++i];
+
+        if (arg == "--file") {
+            options.file = value;
+        } else if (arg == "--picks") {
+            options.picks = std::stoul(value);
+        } else if (arg == "--entries") {
+            options.entries = std::stoul(value);
+        } else if (arg == "--seed") {
+            options.seed = static_cast<uint32_t>(std::stoul(value));
+        } else if (arg == "--threads") {
+            options.threads = static_cast<unsigned>(std::stoul(value));
+        } else {
+            std::cerr << "unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+//! The entry weights of each table in the loot definitions at @p file, by id.
+//------------------------------------------------------------------------------
+std::vector<std::pair<std::string, std::vector<double>>> read_weights(std::string const& file) {
+    std::ifstream in {file};
+    auto const root = tez::detail::parse_json(in);
+
+    std::vector<std::pair<std::string, std::vector<double>>> result;
+
+    for (auto const& table : root["tables"]) {
+        std::vector<double> weights;
+        for (auto const& entry : table["table"]) {
+            weights.push_back(entry[0u].asDouble());
+        }
+
+        result.emplace_back(table["id"].asString(), std::move(weights));
+    }
+
+    return result;
+}
+
+//------------------------------------------------------------------------------
+//! Millions of calls of @p pick per second; the indices are summed so the
+//! loop can not be optimized away.
+//------------------------------------------------------------------------------
+template <typename Pick>
+double measure(size_t const n, Pick pick, size_t& sink) {
+    auto const t0 = clock_type::now();
+
+    size_t sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += pick();
+    }
+
+    auto const elapsed = ms(clock_type::now() - t0).count();
+    sink += sum;
+
+    return elapsed > 0.0 ? n / elapsed / 1000.0 : 0.0;
+}
+
+void compare(std::string const& name, std::vector<double> const& weights, options_t const& options, size_t& sink) {
+    if (weights.empty()) {
+        return;
+    }
+
+    tez::random_t random {options.seed};
+
+    std::discrete_distribution<> discrete(std::begin(weights), std::end(weights));
+    tez::alias_table const       alias {weights};
+
+    auto const a = measure(options.picks, [&] { return static_cast<size_t>(discrete(random)); }, sink);
+    auto const b = measure(options.picks, [&] { return static_cast<size_t>(alias(random)); }, sink);
+
+    std::cerr << std::left  << std::setw(16) << name
+              << std::right << std::setw(9)  << weights.size()
+              << std::setw(14) << a
+              << std::setw(14) << b
+              << std::setw(10) << (a > 0.0 ? b / a : 0.0) << "x\n";
+}
+
+} //namespace
+
+int main(int argc, char const* argv[]) {
+    options_t options;
+    if (!parse_options(argc, argv, options)) {
+        return 1;
+    }
+
+    size_t sink = 0;
+
+    std::cerr << std::fixed << std::setprecision(2)
+        << "picks:   " << options.picks << "\n"
+        << "table          entries  discrete M/s     alias M/s   speedup\n";
+
+    for (auto const& table : read_weights(options.file)) {
+        compare(table.first, table.second, options, sink);
+    }
+
+    {
+        tez::random_t random {options.seed};
+        std::uniform_int_distribution<> dist {1, 1000};
+
+        std::vector<double> weights(options.entries);
+        for (auto& w : weights) {
+            w = dist(random);
+        }
+
+        compare("synthetic", weights, options, sink);
+    }
+
+    //full rolls, nested tables and counts included
+    tez::loot_table_table::reload(options.file);
+    tez::loot_program const program {tez::loot_table_table::data()};
+
+    std::cerr << "table          table M/s  program M/s  batch M/s   items/roll\n";
+
+    for (auto const& table : read_weights(options.file)) {
+        auto const loot  = tez::loot_table_table::get(table.first);
+        auto const index = program.find(table.first);
+        if (!loot || index == tez::loot_program::NO_TABLE) {
+            continue;
+        }
+
+        auto const rolls = options.picks / 10;
+
+        tez::loot_table::item_list   items;
+        tez::loot_table::history_t   history;
+        tez::loot_program::stack_t   stack;
+        tez::loot_batch              batch;
+
+        size_t count = 0;
+
+        tez::random_t random {options.seed};
+        auto const a = measure(rolls, [&] {
+            items.clear();
+            loot->roll(random, items, history);
+            count += items.size();
+            return items.size();
+        }, sink);
+
+        random.seed(options.seed);
+        auto const b = measure(rolls, [&] {
+            items.clear();
+            program.roll(index, random, items, stack);
+            return items.size();
+        }, sink);
+
+        size_t const batch_size = 1000;
+
+        random.seed(options.seed);
+        auto const c = measure(rolls / batch_size, [&] {
+            batch.clear();
+            program.roll(index, batch_size, random, batch);
+            return batch.drops.size();
+        }, sink) * batch_size;
+
+        std::cerr << std::left  << std::setw(16) << table.first
+                  << std::right << std::setw(9)  << a
+                  << std::setw(13) << b
+                  << std::setw(11) << c
+                  << std::setw(13) << (rolls ? static_cast<double>(count) / rolls : 0.0)
+                  << "\n";
+    }
+
+    {
+        auto const& tables = tez::loot_table_table::data();
+
+        auto const t0 = clock_type::now();
+
+        tez::loot_analyzer analyze;
+
+        size_t rates = 0;
+        for (auto const& table : tables) {
+            rates += analyze(table.second).size();
+        }
+
+        std::cerr << "analyze:        " << tables.size() << " tables, "
+                  << rates << " rates in " << ms(clock_type::now() - t0).count() << " ms\n";
+
+        auto const t1    = clock_type::now();
+        auto const rolls = static_cast<uint64_t>(options.picks / 10);
+
+        for (auto const& table : tables) {
+            sink += tez::simulate_loot(table.second, rolls, options.seed, options.threads).items.size();
+        }
+
+        std::cerr << "simulate:       " << tables.size() << " tables, "
+                  << rolls << " rolls each on " << tez::worker_count(options.threads)
+                  << " threads in " << ms(clock_type::now() - t1).count() << " ms\n";
+    }
+
+    std::cerr << "checksum:       " << sink << "\n";
+
+    return 0;
+}
@@ -1,9 +1,14 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+
 #include <boost/container/flat_map.hpp>
 
 #include <bklib/config.hpp>
 #include <bklib/util.hpp>
+#include <bklib/json.hpp>
 
 #include "types.hpp"
 
@@ -117,8 +122,50 @@ struct hash_wrapper : public hash_wrapper_base {
 
 namespace detail {
     template <typename Tag> struct tag_traits;
+
+    //--------------------------------------------------------------------------
+    //! Called by data_table<Tag>::reload with the newly loaded data, before it
+    //! is used; found by ADL, so overload it in the namespace of a Tag whose
+    //! values refer to each other to resolve those references once.
+    //--------------------------------------------------------------------------
+    template <typename Tag, typename Container>
+    inline void link_table(Tag*, Container&) {
+    }
 }
 
+//==============================================================================
+//! A definition that is well formed json but not valid: a weight or parameter
+//! out of range, say. Thrown by parsers past their json rules, so that the
+//! whole load fails rather than skipping the element; see try_reload.
+//==============================================================================
+class data_error : public std::runtime_error {
+public:
+    explicit data_error(std::string const& what)
+      : std::runtime_error {what}
+    {
+    }
+};
+
+//==============================================================================
+//! A table of immutable definitions loaded from a file, readable from any
+//! number of threads while it is reloaded.
+//!
+//! Each load builds a new container, links it (see detail::link_table) and
+//! publishes it as the current snapshot with an atomic pointer swap; readers
+//! never lock and never see a partly built table. Replaced snapshots are
+//! retired rather than freed: pointers from get() and data() stay valid until
+//! the next reclaim(), so only the thread that calls reclaim() (the owner of
+//! the table, between frames say) may use them. Any other thread holds what
+//! it reads: a snapshot(), or an entry from hold(); reclaim() never frees a
+//! snapshot that is still held.
+//!
+//! Taking a snapshot is lock-free too: the reader marks itself as pinning,
+//! loads the current snapshot_t and copies it (a reference count increment).
+//! reclaim() frees nothing while any reader is pinning, so the snapshot_t
+//! being copied cannot be freed under it; those snapshots are freed by a later
+//! reclaim() instead. Workers that look up many entries should take one
+//! snapshot() per job and use get(snapshot, ref).
+//==============================================================================
 template <typename Tag>
 struct data_table {
     using traits      = detail::tag_traits<Tag>;
@@ -127,33 +174,232 @@ struct data_table {
         typename traits::ref
       , typename traits::type
     >;
+    using snapshot_t  = std::shared_ptr<container_t const>;
+
+    //--------------------------------------------------------------------------
+    //! An entry together with the snapshot it is in; valid for as long as the
+    //! handle is, whatever is published or reclaimed meanwhile.
+    //--------------------------------------------------------------------------
+    class handle {
+    public:
+        handle() = default;
+
+        handle(snapshot_t snapshot, pointer const value)
+          : snapshot_ {std::move(snapshot)}
+          , value_    {value}
+        {
+        }
 
-    static bool is_loaded() { return is_loaded_; }
+        explicit operator bool() const BK_NOEXCEPT { return value_ != nullptr; }
+
+        typename traits::type const& operator*() const {
+            BK_ASSERT(value_);
+            return *value_;
+        }
+
+        pointer operator->() const {
+            BK_ASSERT(value_);
+            return value_;
+        }
+
+        pointer           get()      const BK_NOEXCEPT { return value_; }
+        snapshot_t const& snapshot() const BK_NOEXCEPT { return snapshot_; }
+    private:
+        snapshot_t snapshot_;
+        pointer    value_ = nullptr;
+    };
+
+    static bool is_loaded() {
+        return state_.current.load(std::memory_order_acquire) != nullptr;
+    }
 
     static void reload(bklib::utf8string filename) {
         typename traits::parser parser {filename};
         parser.parse();
 
-        if (!is_loaded()) {
-            data_ = parser.get();
-        } else {
-            BK_DEBUG_BREAK(); //TODO
+        publish(parser.get());
+    }
+
+    static void reload(std::istream& in) {
+        typename traits::parser parser {in};
+        parser.parse();
+
+        publish(parser.get());
+    }
+
+    //--------------------------------------------------------------------------
+    //! Like reload, but a file that cannot be read, parsed or validated (see
+    //! data_error) is reported and the current snapshot kept; for reloading
+    //! files as they are edited.
+    //! @returns whether a new snapshot was published.
+    //--------------------------------------------------------------------------
+    static bool try_reload(bklib::utf8string const& filename) {
+        std::ifstream in {filename};
+        if (!in) {
+            std::cout << "couldn't open " << filename << std::endl;
+            return false;
         }
 
-        is_loaded_ = true;
+        return try_reload(in);
+    }
+
+    static bool try_reload(std::istream& in) {
+        Json::Reader reader;
+        Json::Value  root;
+
+        if (!reader.parse(in, root)) {
+            std::cout << reader.getFormattedErrorMessages();
+            return false;
+        }
+
+        typename traits::parser parser;
+
+        try {
+            parser.parse(root);
+        } catch (bklib::json::error::base const& e) {
+            std::cout << boost::diagnostic_information(e);
+            return false;
+        } catch (data_error const& e) {
+            std::cout << e.what() << std::endl;
+            return false;
+        }
+
+        publish(parser.get());
+
+        return true;
+    }
+
+    //--------------------------------------------------------------------------
+    //! Link @p data and make it the current snapshot.
+    //--------------------------------------------------------------------------
+    static void publish(container_t&& data) {
+        auto next = std::make_shared<container_t>(std::move(data));
+        link_table(static_cast<Tag*>(nullptr), *next);
+
+        auto node = std::make_unique<snapshot_t const>(std::move(next));
+        auto const current = node->get();
+
+        std::lock_guard<std::mutex> lock {state_.mutex};
+
+        state_.data.store(node.get());
+        state_.current.store(current, std::memory_order_release);
+
+        retire_(std::move(node));
+    }
+
+    //--------------------------------------------------------------------------
+    //! Retire the current snapshot, leaving nothing loaded.
+    //--------------------------------------------------------------------------
+    static void unload() {
+        std::lock_guard<std::mutex> lock {state_.mutex};
+
+        state_.data.store(nullptr);
+        state_.current.store(nullptr, std::memory_order_release);
+
+        retire_(nullptr);
+    }
+
+    //--------------------------------------------------------------------------
+    //! Free the snapshots replaced since the last call, unless a snapshot_t
+    //! still holds them; invalidates pointers from get() into them. If a
+    //! snapshot() or hold() is under way on another thread, nothing is freed
+    //! until a later call.
+    //--------------------------------------------------------------------------
+    static void reclaim() {
+        std::lock_guard<std::mutex> lock {state_.mutex};
+
+        //every node in retired was replaced before this load; a reader that
+        //pins after it can only see the current node.
+        if (state_.pinned.load() == 0) {
+            state_.retired.clear();
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    //! The current snapshot; null if nothing is loaded.
+    //--------------------------------------------------------------------------
+    static snapshot_t snapshot() {
+        return load_();
+    }
+
+    //! the current table; valid for as long as pointers from get() are.
+    static container_t const& data() {
+        auto const current = state_.current.load(std::memory_order_acquire);
+        BK_ASSERT(current);
+        return *current;
     }
 
     static pointer const get(hash_wrapper<Tag> ref) {
-        BK_ASSERT(is_loaded_);
+        auto const current = state_.current.load(std::memory_order_acquire);
+        BK_ASSERT(current);
 
-        auto const key = typename traits::ref {ref.value};
+        return find_(*current, ref);
+    }
 
-        auto const where = data_.find(key);
-        return where != std::cend(data_) ? &where->second : nullptr;
+    static pointer const get(snapshot_t const& snapshot, hash_wrapper<Tag> ref) {
+        BK_ASSERT(snapshot);
+        return find_(*snapshot, ref);
+    }
+
+    //--------------------------------------------------------------------------
+    //! The entry for @p ref in the current snapshot, held with it; for threads
+    //! other than the one calling reclaim().
+    //! @returns an empty handle if nothing is loaded or there is no such entry.
+    //--------------------------------------------------------------------------
+    static handle hold(hash_wrapper<Tag> ref) {
+        auto snapshot = load_();
+        if (!snapshot) {
+            return handle {};
+        }
+
+        auto const value = find_(*snapshot, ref);
+        return value ? handle {std::move(snapshot), value} : handle {};
     }
 private:
-    static bool        is_loaded_;
-    static container_t data_;
+    static pointer const find_(container_t const& data, hash_wrapper<Tag> ref) {
+        auto const key = typename traits::ref {ref.value};
+
+        auto const where = data.find(key);
+        return where != std::cend(data) ? &where->second : nullptr;
+    }
+
+    using node_t = std::unique_ptr<snapshot_t const>;
+
+    //--------------------------------------------------------------------------
+    //! Copy the current snapshot_t while pinned, so reclaim() cannot free it.
+    //--------------------------------------------------------------------------
+    static snapshot_t load_() {
+        ++state_.pinned;
+
+        auto const data = state_.data.load();
+        auto result = data ? *data : snapshot_t {};
+
+        --state_.pinned;
+
+        return result;
+    }
+
+    //! make @p node the live node, and retire the one it replaces.
+    static void retire_(node_t&& node) {
+        if (state_.live) {
+            state_.retired.push_back(std::move(state_.live));
+        }
+
+        state_.live = std::move(node);
+    }
+
+    struct state_t {
+        std::atomic<snapshot_t const*>     data;    //!< live.get(), for load_()
+        std::atomic<container_t const*>    current; //!< the container of data, for get()
+        std::atomic<size_t>                pinned;  //!< readers in load_()
+        node_t                             live;    //!< the current snapshot
+        std::vector<node_t>                retired;
+        std::mutex                         mutex;   //!< for publish and reclaim
+
+        state_t() : data {nullptr}, current {nullptr}, pinned {0} {}
+    };
+
+    static state_t state_;
 };
 
 ////////////////////////////////////////////////////////////////////////////////